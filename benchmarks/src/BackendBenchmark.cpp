@@ -0,0 +1,84 @@
+//
+// Writes the same synthetic recording through every storage backend/compression combination and reports
+// throughput and output size. Usage: backend_benchmark [messages] [payload bytes] [output dir]
+//
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <RosbagWriter/RosbagWriter.h>
+
+namespace {
+    struct Config {
+        CRLRosWriter::StorageFormat format;
+        CRLRosWriter::CompressionType compression;
+        const char *name;
+    };
+
+    double writeBag(const Config &config, const std::filesystem::path &path, int messages, size_t payloadSize) {
+        std::vector<uint8_t> image(payloadSize);
+        for (size_t i = 0; i < image.size(); ++i)
+            image[i] = static_cast<uint8_t>((i * 7) ^ (i >> 9));
+        std::string str = "Hello world";
+        std::vector<uint8_t> small(str.begin(), str.end());
+
+        auto begin = std::chrono::steady_clock::now();
+        {
+            CRLRosWriter::RosbagWriter writer(config.format);
+            writer.setCompression(config.compression);
+            writer.open(path);
+            auto imageConn = writer.getConnection("/camera/image", "sensor_msgs/Image");
+            auto stringConn = writer.getConnection("/status", "std_msgs/String");
+            int64_t timestamp = 1'700'000'000'000'000'000;
+            for (int i = 0; i < messages; ++i) {
+                timestamp += 33'000'000;
+                writer.write(imageConn, timestamp, writer.serializeImage(static_cast<uint32_t>(i), timestamp, 1,
+                                                                         static_cast<uint32_t>(payloadSize),
+                                                                         image.data(),
+                                                                         static_cast<uint32_t>(image.size()), "mono8",
+                                                                         1));
+                writer.write(stringConn, timestamp, small);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        return std::chrono::duration<double>(elapsed).count();
+    }
+}
+
+int main(int argc, char **argv) {
+    int messages = argc > 1 ? std::atoi(argv[1]) : 1000;
+    size_t payloadSize = argc > 2 ? static_cast<size_t>(std::atol(argv[2])) : 1 << 20;
+    std::filesystem::path outDir = argc > 3 ? argv[3] : std::filesystem::temp_directory_path();
+
+    const std::vector<Config> configs = {
+            {CRLRosWriter::StorageFormat::ROSBAG_V2, CRLRosWriter::CompressionType::NONE, "rosbag v2 / none"},
+            {CRLRosWriter::StorageFormat::ROSBAG_V2, CRLRosWriter::CompressionType::LZ4,  "rosbag v2 / lz4"},
+            {CRLRosWriter::StorageFormat::ROSBAG_V2, CRLRosWriter::CompressionType::BZ2,  "rosbag v2 / bz2"},
+            {CRLRosWriter::StorageFormat::MCAP,      CRLRosWriter::CompressionType::NONE, "mcap / none"},
+            {CRLRosWriter::StorageFormat::MCAP,      CRLRosWriter::CompressionType::LZ4,  "mcap / lz4"},
+            {CRLRosWriter::StorageFormat::MCAP,      CRLRosWriter::CompressionType::ZSTD, "mcap / zstd"},
+    };
+
+    std::cout << std::left << std::setw(20) << "backend" << std::right << std::setw(12) << "seconds"
+              << std::setw(12) << "MB/s" << std::setw(14) << "file MB" << std::endl;
+    for (const Config &config: configs) {
+        if (!CRLRosWriter::isCompressionAvailable(config.compression)) {
+            std::cout << std::left << std::setw(20) << config.name << " skipped (codec not available)" << std::endl;
+            continue;
+        }
+        std::filesystem::path path = outDir / "backend_benchmark.tmp";
+        double seconds = writeBag(config, path, messages, payloadSize);
+        double inputMB = static_cast<double>(messages) * static_cast<double>(payloadSize) / (1 << 20);
+        double fileMB = static_cast<double>(std::filesystem::file_size(path)) / (1 << 20);
+        std::filesystem::remove(path);
+
+        std::cout << std::left << std::setw(20) << config.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << seconds << std::setw(12) << std::setprecision(1) << inputMB / seconds
+                  << std::setw(14) << fileMB << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,140 @@
+#ifndef ROSBAG_WRITER_CPP_BAGDATASET_H
+#define ROSBAG_WRITER_CPP_BAGDATASET_H
+
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "RosbagReader/RosbagReader.h"
+
+namespace CRLRosReader {
+
+    // Connection of the dataset. Connections of different bags with the same topic, type and md5sum share one id.
+    struct DatasetConnection {
+        uint32_t id = 0;
+        std::string topic;
+        std::string msgType;
+        std::string md5sum;
+        std::string msgDef;
+    };
+
+    struct DatasetChunk {
+        uint32_t bag = 0;
+        uint64_t pos = 0;
+        int64_t start = 0;
+        int64_t end = 0;
+        std::map<uint32_t, uint32_t> messageCounts; // dataset connection id -> messages in chunk
+    };
+
+    struct DatasetMessage {
+        const DatasetConnection *connection = nullptr;
+        uint32_t bag = 0;
+        int64_t time = 0;
+        // The message bytes are chunk[begin, end), the chunk stays alive as long as a message refers to it
+        std::shared_ptr<const std::vector<uint8_t>> chunk;
+        size_t begin = 0;
+        size_t end = 0;
+
+        const uint8_t *data() const { return chunk->data() + begin; }
+        size_t size() const { return end - begin; }
+    };
+
+    // A set of bags, e.g. the split files of one recording, presented as one logical bag. open() reads the index
+    // section of every bag in parallel and merges them into one chunk list sorted by time; message data is read on
+    // demand through a small cache of open files, so no more than maxOpenFiles bags are open at any time.
+    // Not thread safe, use one BagDataset per thread.
+    class BagDataset {
+    public:
+        class Cursor;
+
+        explicit BagDataset(size_t maxOpen = 8) : maxOpenFiles(std::max<size_t>(1, maxOpen)) {}
+
+        bool open(const std::vector<std::filesystem::path> &bags, unsigned threads = 0);
+        // All *.bag files in the directory, in natural order (run_2.bag before run_10.bag)
+        bool openDirectory(const std::filesystem::path &directory, unsigned threads = 0);
+
+        const std::vector<std::filesystem::path> &getBags() const { return bags; }
+        const std::vector<DatasetConnection> &getConnections() const { return connections; }
+        const std::vector<DatasetChunk> &getChunks() const { return chunks; } // sorted by start time
+        BagSummary summary() const;
+
+        // Chunks that may hold messages of the given topics (all if empty) in [start, end]
+        std::vector<const DatasetChunk *> query(int64_t start, int64_t end,
+                                                const std::vector<std::string> &topics = {}) const;
+
+        // Messages of the given topics in [start, end] in time order across all bags. Messages with the same time
+        // keep their file order.
+        Cursor messages(int64_t start = std::numeric_limits<int64_t>::min(),
+                        int64_t end = std::numeric_limits<int64_t>::max(),
+                        const std::vector<std::string> &topics = {});
+
+        // Reads and decompresses a chunk through the file cache.
+        bool readChunk(const DatasetChunk &chunk, std::vector<uint8_t> &data);
+        size_t openFiles() const { return files.size(); }
+
+        class Cursor {
+        public:
+            // Returns false at the end of the range.
+            bool next(DatasetMessage &message);
+            // True if a chunk could not be read, its messages were skipped.
+            bool failed() const { return error; }
+
+        private:
+            friend class BagDataset;
+
+            struct Pending {
+                int64_t time;
+                uint64_t order;
+                uint32_t conn;
+                uint32_t bag;
+                std::shared_ptr<const std::vector<uint8_t>> chunk;
+                size_t begin;
+                size_t end;
+
+                bool operator>(const Pending &other) const {
+                    return time != other.time ? time > other.time : order > other.order;
+                }
+            };
+
+            BagDataset *dataset = nullptr;
+            int64_t start = 0;
+            int64_t end = 0;
+            std::vector<bool> selected; // by dataset connection id
+            std::vector<const DatasetChunk *> chunks;
+            size_t nextChunk = 0;
+            uint64_t order = 0;
+            bool error = false;
+            std::priority_queue<Pending, std::vector<Pending>, std::greater<>> heap;
+            std::vector<MessageRecord> records;
+
+            void load(const DatasetChunk &chunk);
+        };
+
+    private:
+        struct OpenFile {
+            uint32_t bag = 0;
+            uint64_t lastUse = 0;
+            std::unique_ptr<RosbagReader> reader;
+        };
+
+        size_t maxOpenFiles;
+        std::vector<std::filesystem::path> bags;
+        std::vector<DatasetConnection> connections;
+        std::vector<DatasetChunk> chunks;
+        std::vector<std::map<uint32_t, uint32_t>> connectionIds; // per bag: bag connection id -> dataset id
+        std::vector<BagSummary> bagSummaries;
+        std::vector<OpenFile> files;
+        uint64_t useCounter = 0;
+
+        RosbagReader *acquire(uint32_t bag);
+    };
+
+}
+
+#endif //ROSBAG_WRITER_CPP_BAGDATASET_H
@@ -0,0 +1,40 @@
+#ifndef ROSBAG_WRITER_CPP_BAGEXPORT_H
+#define ROSBAG_WRITER_CPP_BAGEXPORT_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace CRLRosReader {
+
+    struct ExportOptions {
+        std::filesystem::path outputDir;
+        std::vector<std::string> topics;  // empty exports every topic with a known message type
+        unsigned threads = 1;
+        bool binary = false;              // scalar topics as <topic>.bin instead of <topic>.csv
+        int pngCompression = 1;           // zlib level, low levels keep the export disk bound
+    };
+
+    struct ExportResult {
+        uint64_t images = 0;
+        uint64_t rows = 0;
+        uint64_t skipped = 0;                // messages with unsupported encodings or that failed to decode
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        std::vector<uint64_t> failedChunks;  // positions of chunks that could not be read or decompressed
+    };
+
+    // Exports the selected topics of a bag into options.outputDir:
+    //   sensor_msgs/Image     <topic>/<index>_<time>.png, index counts the messages of the topic from 0
+    //   scalar types          <topic>.csv with a "time,<columns>" header, or with options.binary <topic>.bin holding
+    //                         little endian rows of int64 time and 8 byte numeric fields (strings are dropped),
+    //                         column names and types are listed in <topic>.columns
+    // '/' in topic names is replaced by '_'; a topic whose name then collides with an earlier one gets
+    // '_<connection id>' appended, e.g. /a/b -> a_b and /a_b -> a_b_1. Chunks are distributed over threads, each with its own file handle;
+    // image files are written by the thread that decoded them and scalar rows are appended in chunk order, with at
+    // most 2 * threads decoded chunks waiting for their turn.
+    bool exportBag(const std::filesystem::path &filePath, const ExportOptions &options, ExportResult &result);
+
+}
+
+#endif //ROSBAG_WRITER_CPP_BAGEXPORT_H
@@ -0,0 +1,25 @@
+#ifndef ROSBAG_WRITER_CPP_BAGVERIFY_H
+#define ROSBAG_WRITER_CPP_BAGVERIFY_H
+
+#include <filesystem>
+#include <vector>
+
+namespace CRLRosReader {
+
+    struct VerifyResult {
+        uint32_t chunks = 0;
+        uint32_t verified = 0;
+        uint32_t unchecked = 0;          // chunks written without a crc32c field
+        std::vector<uint64_t> corrupt;   // positions of chunks that failed the check or could not be read
+        uint64_t bytes = 0;
+
+        bool ok() const { return corrupt.empty(); }
+    };
+
+    // Checks the crc32c of every chunk listed in the bag index. Chunks are split over threads, each with its own
+    // file handle, so the check runs at close to sequential read speed.
+    bool verifyBag(const std::filesystem::path &filePath, unsigned threads, VerifyResult &result);
+
+}
+
+#endif //ROSBAG_WRITER_CPP_BAGVERIFY_H
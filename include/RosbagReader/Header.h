@@ -5,13 +5,20 @@
 #ifndef ROSBAG_WRITER_CPP_HEADER_H
 #define ROSBAG_WRITER_CPP_HEADER_H
 
-namespace RosbagReader {
-    static uint8_t deserialize_uint8(const std::vector<uint8_t>& bytes, size_t& index) {
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace CRLRosReader {
+    static inline uint8_t deserialize_uint8(const std::vector<uint8_t>& bytes, size_t& index) {
         return bytes[index++];
     }
 
 
-    static int32_t deserialize_int32(const std::vector<uint8_t>& bytes, size_t& index) {
+    static inline int32_t deserialize_int32(const std::vector<uint8_t>& bytes, size_t& index) {
         int32_t val = 0;
         for (int i = 0; i < 4; ++i) {
             val |= (bytes[index++] << (i * 8));
@@ -19,7 +26,7 @@ namespace RosbagReader {
         return val;
     }
 
-    static uint32_t deserialize_uint32(const std::vector<uint8_t>& bytes, size_t& index) {
+    static inline uint32_t deserialize_uint32(const std::vector<uint8_t>& bytes, size_t& index) {
         uint32_t val = 0;
         for (int i = 0; i < 4; ++i) {
             val |= (static_cast<uint32_t>(bytes[index++]) << (i * 8));
@@ -27,7 +34,7 @@ namespace RosbagReader {
         return val;
     }
 
-    static uint64_t deserialize_uint64(const std::vector<uint8_t>& bytes, size_t& index) {
+    static inline uint64_t deserialize_uint64(const std::vector<uint8_t>& bytes, size_t& index) {
         uint64_t val = 0;
         for (int i = 0; i < 8; ++i) {
             val |= (static_cast<uint64_t>(bytes[index++]) << (i * 8));
@@ -36,11 +43,67 @@ namespace RosbagReader {
     }
 
 
-    static int64_t deserialize_time(const std::vector<uint8_t>& bytes, size_t& index) {
+    static inline int64_t deserialize_time(const std::vector<uint8_t>& bytes, size_t& index) {
         int32_t sec = deserialize_int32(bytes, index);
         int32_t nsec = deserialize_int32(bytes, index);
         return static_cast<int64_t>(sec) * 1000000000 + nsec;
     }
 
+    // Parsed record header: a sequence of <uint32 len><name>=<value> fields.
+    class Header {
+    private:
+        std::map<std::string, std::vector<uint8_t>> data;
+
+    public:
+        bool parse(const std::vector<uint8_t> &bytes, size_t begin, size_t end) {
+            data.clear();
+            size_t index = begin;
+            while (index + 4 <= end) {
+                uint32_t len = deserialize_uint32(bytes, index);
+                if (len > end - index)
+                    return false;
+                auto field = bytes.begin() + static_cast<std::ptrdiff_t>(index);
+                auto sep = std::find(field, field + len, '=');
+                if (sep == field + len)
+                    return false;
+                data[std::string(field, sep)] = std::vector<uint8_t>(sep + 1, field + len);
+                index += len;
+            }
+            return index == end;
+        }
+
+        bool has(const std::string &name) const {
+            return data.count(name) != 0;
+        }
+
+        uint8_t get_uint8(const std::string &name) const {
+            auto it = data.find(name);
+            return it == data.end() || it->second.empty() ? 0 : it->second[0];
+        }
+
+        uint32_t get_uint32(const std::string &name) const {
+            auto it = data.find(name);
+            size_t index = 0;
+            return it == data.end() || it->second.size() < 4 ? 0 : deserialize_uint32(it->second, index);
+        }
+
+        uint64_t get_uint64(const std::string &name) const {
+            auto it = data.find(name);
+            size_t index = 0;
+            return it == data.end() || it->second.size() < 8 ? 0 : deserialize_uint64(it->second, index);
+        }
+
+        int64_t get_time(const std::string &name) const {
+            auto it = data.find(name);
+            size_t index = 0;
+            return it == data.end() || it->second.size() < 8 ? 0 : deserialize_time(it->second, index);
+        }
+
+        std::string get_string(const std::string &name) const {
+            auto it = data.find(name);
+            return it == data.end() ? std::string() : std::string(it->second.begin(), it->second.end());
+        }
+    };
+
 }
 #endif //ROSBAG_WRITER_CPP_HEADER_H
@@ -0,0 +1,51 @@
+#ifndef ROSBAG_WRITER_CPP_MESSAGEDECODERS_H
+#define ROSBAG_WRITER_CPP_MESSAGEDECODERS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace CRLRosReader {
+
+    // std_msgs/Header, stamp in nanoseconds
+    struct RosHeader {
+        uint32_t seq = 0;
+        int64_t stamp = 0;
+        std::string frameId;
+    };
+
+    // sensor_msgs/Image as written by RosbagWriter::serializeImage. data points into the decoded buffer.
+    struct ImageMessage {
+        RosHeader header;
+        uint32_t height = 0;
+        uint32_t width = 0;
+        std::string encoding;
+        uint8_t isBigEndian = 0;
+        uint32_t step = 0;
+        const uint8_t *data = nullptr;
+        uint32_t dataSize = 0;
+    };
+
+    // Decoders take the message bytes as bytes[begin, end) (see MessageRecord) and fail on truncated input.
+    bool decodeHeader(const std::vector<uint8_t> &bytes, size_t &index, size_t end, RosHeader &header);
+    bool decodeImage(const std::vector<uint8_t> &bytes, size_t begin, size_t end, ImageMessage &image);
+
+    // Flat row representation used to export non-image topics to CSV or binary arrays.
+    using FieldValue = std::variant<int64_t, double, std::string>;
+
+    struct ScalarDecoder {
+        std::vector<std::string> columns;
+        std::function<bool(const std::vector<uint8_t> &bytes, size_t begin, size_t end,
+                           std::vector<FieldValue> &row)> decode;
+    };
+
+    // std_msgs/Header, std_msgs/String and sensor_msgs/Temperature are registered by default. Register additional
+    // types before starting an export, the registry is not locked.
+    void registerScalarDecoder(const std::string &msgType, ScalarDecoder decoder);
+    const ScalarDecoder *findScalarDecoder(const std::string &msgType);
+
+}
+
+#endif //ROSBAG_WRITER_CPP_MESSAGEDECODERS_H
@@ -0,0 +1,100 @@
+#ifndef ROSBAG_WRITER_CPP_PLAYER_H
+#define ROSBAG_WRITER_CPP_PLAYER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "RosbagReader/BagDataset.h"
+
+namespace CRLRosReader {
+
+    struct PlaybackOptions {
+        double rate = 1.0;                              // 2.0 plays twice as fast, 0 plays as fast as possible
+        int64_t start = std::numeric_limits<int64_t>::min();
+        int64_t end = std::numeric_limits<int64_t>::max();
+        std::vector<std::string> topics;                // empty plays every topic
+        uint64_t prefetchBytes = 64 * (1 << 20);        // decoded chunk data buffered ahead of the playhead
+        std::chrono::microseconds spin{200};            // busy wait this long before each deadline instead of sleeping
+    };
+
+    // Delivery lateness (actual minus scheduled delivery time) of the messages played so far.
+    struct PlaybackStats {
+        static constexpr int64_t BUCKET_NS = 1000;      // histogram resolution
+        static constexpr size_t BUCKETS = 100'000;      // up to 100 ms, later deliveries go to the last bucket
+
+        uint64_t delivered = 0;
+        uint64_t underruns = 0;     // times the playhead had to wait for the I/O thread
+        uint64_t peakQueued = 0;    // bytes of buffers held by the prefetch queue at most
+        int64_t maxLateness = 0;    // ns
+        double meanLateness = 0;    // ns
+        std::vector<uint64_t> histogram;
+
+        // Lateness in ns that the given fraction of deliveries (e.g. 0.99) did not exceed, at BUCKET_NS resolution.
+        int64_t percentile(double fraction) const;
+    };
+
+    // Replays a bag, or a set of split bags, to a callback at the pace of the recorded timestamps. An I/O thread reads
+    // and decodes chunks ahead of the playhead into a queue bounded by prefetchBytes; play() runs the clock on the
+    // calling thread and only waits on that queue, so file reads do not delay deliveries. Queued messages share
+    // their chunk buffer, which counts once against prefetchBytes; messages much smaller than their chunk are
+    // copied out, so a filtered small-message topic does not keep whole chunks of other topics alive. Not counted
+    // are the chunks the I/O thread is still reading messages from.
+    class Player {
+    public:
+        using Callback = std::function<void(const DatasetMessage &)>;
+
+        explicit Player(PlaybackOptions playbackOptions = PlaybackOptions()) : options(std::move(playbackOptions)) {}
+        ~Player();
+
+        bool open(const std::filesystem::path &bag);
+        bool open(const std::vector<std::filesystem::path> &bags);
+        bool openDirectory(const std::filesystem::path &directory);
+
+        // Blocks until every message is delivered or stop() is called. Returns false if a chunk could not be read.
+        // An exception thrown by the callback stops the I/O thread and propagates; play() may be called again.
+        bool play(const Callback &callback);
+        // May be called from the callback or any other thread.
+        void stop();
+
+        // Safe to call while playing, reads counters without taking a lock the playback thread waits on.
+        PlaybackStats getStats() const;
+
+    private:
+        PlaybackOptions options;
+        BagDataset dataset;
+        std::thread io;
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<DatasetMessage> queue;
+        std::unordered_map<const std::vector<uint8_t> *, size_t> queuedBuffers; // buffer -> queued messages using it
+        uint64_t queuedBytes = 0;   // distinct buffers plus per-message overhead
+        bool ioDone = false;
+        bool ioFailed = false;
+        std::atomic<bool> stopping{false};
+
+        // PlaybackStats as counters with a single writer each (the I/O thread for peakQueued, the playback thread for
+        // the rest), so a getStats() poll never delays a delivery
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> underruns{0};
+        std::atomic<uint64_t> peakQueued{0};
+        std::atomic<int64_t> maxLateness{0};
+        std::atomic<double> meanLateness{0};
+        std::unique_ptr<std::atomic<uint64_t>[]> histogram{new std::atomic<uint64_t>[PlaybackStats::BUCKETS]()};
+
+        void prefetch();
+        void joinIo();
+        void dequeue(DatasetMessage &message);
+        void record(int64_t lateness);
+    };
+
+}
+
+#endif //ROSBAG_WRITER_CPP_PLAYER_H
@@ -6,23 +6,105 @@
 #define ROSBAG_WRITER_CPP_ROSBAGREADER_H
 
 
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <string>
 #include "Header.h"
 
-class RosbagReader {
-    std::fstream bio;
+namespace CRLRosReader {
 
-public:
-    void open(const std::filesystem::path &filePath);
-    void readHeader();
-    void readData();
-    void deserializeMessage(const std::vector<uint8_t>& message);
-    // Additional methods to handle specific types of data, e.g., images or IMU data
-};
+    struct ConnectionInfo {
+        uint32_t id = 0;
+        std::string topic;
+        std::string msgType;
+        std::string md5sum;
+        std::string msgDef;
+    };
 
+    struct ChunkInfo {
+        uint64_t pos = 0;
+        int64_t start = 0;
+        int64_t end = 0;
+        std::map<uint32_t, uint32_t> messageCounts; // connection id -> messages in chunk
+    };
+
+    // CHUNK record as stored in the file
+    struct ChunkRecord {
+        uint64_t pos = 0;
+        std::string compression;
+        uint32_t size = 0; // uncompressed size
+        bool hasCrc = false;
+        uint32_t crc = 0;  // crc32c of data, written by RosbagWriter
+        std::vector<uint8_t> data;
+    };
+
+    // MSGDATA record inside an uncompressed chunk payload, the message bytes are data[begin, end)
+    struct MessageRecord {
+        uint32_t conn = 0;
+        int64_t time = 0;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    struct TopicInfo {
+        std::string topic;
+        std::string msgType;
+        uint64_t messageCount = 0;
+        uint32_t connections = 0;
+    };
+
+    struct BagSummary {
+        std::filesystem::path path;
+        uint64_t fileSize = 0;
+        int64_t start = 0;
+        int64_t end = 0;
+        uint64_t messageCount = 0;
+        uint32_t chunkCount = 0;
+        std::vector<TopicInfo> topics;
+
+        double duration() const { return static_cast<double>(end - start) / 1e9; }
+    };
+
+    class RosbagReader {
+        std::ifstream bio;
+        std::filesystem::path path;
+        uint64_t fileSize = 0;
+        uint64_t indexPos = 0;
+        uint32_t connCount = 0;
+        uint32_t chunkCount = 0;
+        std::vector<ConnectionInfo> connections;
+        std::vector<ChunkInfo> chunks;
+
+        bool readIndex();
+
+    public:
+        bool open(const std::filesystem::path &filePath);
+
+        // Reads the bag header record and the index section it points to. Only touches the first 4 KiB and the
+        // tail of the file starting at index_pos, so the cost does not depend on the amount of message data.
+        bool readHeader();
+
+        BagSummary summary() const;
+
+        // Reads the CHUNK record at pos (ChunkInfo::pos). chunk.data is reused, so keep one ChunkRecord per thread.
+        bool readChunk(uint64_t pos, ChunkRecord &chunk);
+
+        const std::vector<ConnectionInfo> &getConnections() const { return connections; }
+        const std::vector<ChunkInfo> &getChunks() const { return chunks; }
+    };
+
+    // Replaces chunk.data with the uncompressed payload. No-op for uncompressed chunks, fails for unknown codecs.
+    bool decompressChunk(ChunkRecord &chunk);
+
+    // Lists the MSGDATA records of an uncompressed chunk payload in file order, CONNECTION records are skipped.
+    bool parseMessages(const std::vector<uint8_t> &data, std::vector<MessageRecord> &messages);
+
+    // Convenience for batch tools: open + readHeader + summary.
+    bool readSummary(const std::filesystem::path &filePath, BagSummary &summary);
+
+}
 
 
 #endif //ROSBAG_WRITER_CPP_ROSBAGREADER_H
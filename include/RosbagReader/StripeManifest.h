@@ -0,0 +1,44 @@
+#ifndef ROSBAG_WRITER_CPP_STRIPEMANIFEST_H
+#define ROSBAG_WRITER_CPP_STRIPEMANIFEST_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "RosbagReader/RosbagReader.h"
+
+namespace CRLRosReader {
+
+    // Describes a recording striped over several standalone bags (see CRLRosWriter::StripedWriter) and holds a
+    // global time index over all of their chunks, so the set can be queried as one logical bag.
+    struct StripeManifest {
+        struct Topic {
+            uint32_t stripe = 0;
+            std::string topic;
+            std::string msgType;
+        };
+
+        struct Chunk {
+            int64_t start = 0;
+            int64_t end = 0;
+            uint32_t stripe = 0;
+            uint64_t pos = 0;
+        };
+
+        std::vector<std::filesystem::path> stripes;
+        std::vector<Topic> topics;
+        std::vector<Chunk> chunks; // sorted by start time
+
+        // Chunks of any stripe that may hold messages in [start, end]
+        std::vector<Chunk> query(int64_t start, int64_t end) const;
+    };
+
+    // Reads the index section of every stripe and merges their chunk ranges into one time index.
+    bool buildStripeManifest(const std::vector<std::filesystem::path> &stripes, StripeManifest &manifest);
+
+    bool writeStripeManifest(const std::filesystem::path &filePath, const StripeManifest &manifest);
+    bool readStripeManifest(const std::filesystem::path &filePath, StripeManifest &manifest);
+
+}
+
+#endif //ROSBAG_WRITER_CPP_STRIPEMANIFEST_H
@@ -0,0 +1,53 @@
+#ifndef ROSBAG_WRITER_CPP_TIMEINDEX_H
+#define ROSBAG_WRITER_CPP_TIMEINDEX_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <RosbagWriter/TimeIndexFormat.h>
+
+namespace CRLRosReader {
+
+    using CRLRosWriter::TimeIndexEntry;
+
+    // Memory mapped per-connection time index written next to a bag by RosbagWriter::setTimeIndex(true).
+    // seek() is a binary search over the mapped array, no part of the bag is read.
+    class TimeIndex {
+    public:
+        TimeIndex() = default;
+        TimeIndex(const TimeIndex &) = delete;
+        TimeIndex &operator=(const TimeIndex &) = delete;
+        ~TimeIndex();
+
+        static std::filesystem::path sidecarPath(const std::filesystem::path &bag) {
+            return std::filesystem::path(bag.string() + ".tidx");
+        }
+
+        // Maps the sidecar of the given bag. Fails if it is missing or was written for a different bag size.
+        bool open(const std::filesystem::path &bag);
+        void close();
+
+        std::vector<uint32_t> getConnections() const;
+        size_t count(uint32_t conn) const;
+
+        // First message of conn with time >= the given time, or nullptr if there is none.
+        const TimeIndexEntry *seek(uint32_t conn, int64_t time) const;
+
+        // All entries of conn, sorted by time.
+        const TimeIndexEntry *begin(uint32_t conn) const;
+        const TimeIndexEntry *end(uint32_t conn) const;
+
+    private:
+        const uint8_t *base = nullptr;
+        size_t size = 0;
+        std::vector<uint8_t> buffer; // used where mmap is not available
+        const CRLRosWriter::TimeIndexDirectoryEntry *directory = nullptr;
+        uint32_t connCount = 0;
+
+        const CRLRosWriter::TimeIndexDirectoryEntry *find(uint32_t conn) const;
+    };
+
+}
+
+#endif //ROSBAG_WRITER_CPP_TIMEINDEX_H
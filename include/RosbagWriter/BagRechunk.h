@@ -0,0 +1,34 @@
+#ifndef ROSBAGWRITER_BAGRECHUNK_H
+#define ROSBAGWRITER_BAGRECHUNK_H
+
+#include <filesystem>
+
+#include <RosbagWriter/Compression.h>
+
+namespace CRLRosWriter {
+
+    struct RechunkOptions {
+        CompressionType compression = CompressionType::NONE;
+        uint64_t chunkThreshold = 20 * (1 << 20);  // clamped below the 4 GiB chunk size limit of the format
+        unsigned threads = 1;
+    };
+
+    struct RechunkResult {
+        uint32_t inputChunks = 0;
+        uint32_t outputChunks = 0;
+        uint64_t messages = 0;
+        uint64_t bytesRead = 0;     // chunk payloads as stored in the input
+        uint64_t bytesWritten = 0;  // size of the output bag
+    };
+
+    // Rewrites a ROS 1 bag with a different chunk compression and chunk size, keeping the message order.
+    // Input chunks are read and decompressed by a pool of threads, regrouped into new chunks in file order and
+    // compressed by a second pool; the chunks are written in order and IDXDATA/CHUNK_INFO are rebuilt for the new
+    // layout. At most 2 * threads chunks are in flight in each stage.
+    // The bag is written to output + ".tmp" and renamed over output on success; output may not be the input.
+    bool rechunkBag(const std::filesystem::path &input, const std::filesystem::path &output,
+                    const RechunkOptions &options, RechunkResult &result);
+
+}
+
+#endif // ROSBAGWRITER_BAGRECHUNK_H
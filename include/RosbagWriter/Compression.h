@@ -0,0 +1,27 @@
+#ifndef ROSBAGWRITER_COMPRESSION_H
+#define ROSBAGWRITER_COMPRESSION_H
+
+#include <string>
+
+namespace CRLRosWriter {
+
+    // Chunk compression codecs. Which ones are usable depends on the libraries found at configure time,
+    // see isCompressionAvailable().
+    enum class CompressionType : int {
+        NONE = 0,
+        LZ4 = 1,
+        ZSTD = 2,
+        BZ2 = 3     // ROS 1 bag only, MCAP has no bz2 compression
+    };
+
+    bool isCompressionAvailable(CompressionType type);
+
+    // Compresses src into dst (dst is overwritten). Returns false if the codec is unavailable or failed.
+    bool compress(CompressionType type, const std::string &src, std::string &dst);
+
+    // Decompresses src into dst. uncompressedSize is the size recorded next to the chunk in both container formats.
+    bool decompress(CompressionType type, const std::string &src, std::string &dst, size_t uncompressedSize);
+
+}
+
+#endif // ROSBAGWRITER_COMPRESSION_H
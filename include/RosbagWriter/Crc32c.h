@@ -0,0 +1,18 @@
+#ifndef ROSBAGWRITER_CRC32C_H
+#define ROSBAGWRITER_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace CRLRosWriter {
+
+    // CRC-32C (Castagnoli). Uses the SSE4.2 / ARMv8 CRC32 instructions when the CPU has them, otherwise a
+    // slicing-by-8 table. Pass the previous result as crc to checksum data in pieces.
+    uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0);
+
+    // Table implementation, exposed for testing the hardware path against it
+    uint32_t crc32c_sw(const void *data, size_t size, uint32_t crc = 0);
+
+}
+
+#endif // ROSBAGWRITER_CRC32C_H
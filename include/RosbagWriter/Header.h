@@ -17,6 +17,14 @@ namespace CRLRosWriter {
         return {val};
     }
 
+    static inline std::vector<uint8_t> serialize_uint16(uint16_t val) {
+        std::vector<uint8_t> bytes(2);
+        for (int i = 0; i < 2; ++i) {
+            bytes[i] = (val >> (i * 8)) & 0xFF;
+        }
+        return bytes;
+    }
+
     static std::vector<uint8_t> serialize_int32(int32_t val) {
         std::vector<uint8_t> bytes(4);
         for (int i = 0; i < 4; ++i) {
@@ -0,0 +1,122 @@
+#ifndef ROSBAGWRITER_MCAPBACKEND_H
+#define ROSBAGWRITER_MCAPBACKEND_H
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include <RosbagWriter/StorageBackend.h>
+
+namespace CRLRosWriter {
+
+    static constexpr char MCAP_MAGIC[] = {'\x89', 'M', 'C', 'A', 'P', '0', '\r', '\n'};
+
+// MCAP record opcodes (https://mcap.dev/spec)
+    enum class McapOpcode : uint8_t {
+        HEADER = 0x01,
+        FOOTER = 0x02,
+        SCHEMA = 0x03,
+        CHANNEL = 0x04,
+        MESSAGE = 0x05,
+        CHUNK = 0x06,
+        MESSAGE_INDEX = 0x07,
+        CHUNK_INDEX = 0x08,
+        STATISTICS = 0x0B,
+        SUMMARY_OFFSET = 0x0E,
+        DATA_END = 0x0F
+    };
+
+// Builds the content of a single MCAP record: opcode, uint64 length, fields.
+    class McapRecord {
+    private:
+        std::vector<uint8_t> content;
+
+        void append(const std::vector<uint8_t> &bytes) {
+            content.insert(content.end(), bytes.begin(), bytes.end());
+        }
+
+    public:
+        void put_uint8(uint8_t value) { content.push_back(value); }
+
+        void put_uint16(uint16_t value) { append(serialize_uint16(value)); }
+
+        void put_uint32(uint32_t value) { append(serialize_uint32(value)); }
+
+        void put_uint64(uint64_t value) { append(serialize_uint64(value)); }
+
+        void put_string(const std::string &value) {
+            put_uint32(static_cast<uint32_t>(value.size()));
+            content.insert(content.end(), value.begin(), value.end());
+        }
+
+        void put_map(const std::map<std::string, std::string> &value) {
+            uint32_t size = 0;
+            for (const auto &[key, val]: value)
+                size += static_cast<uint32_t>(8 + key.size() + val.size());
+            put_uint32(size);
+            for (const auto &[key, val]: value) {
+                put_string(key);
+                put_string(val);
+            }
+        }
+
+        void put_map(const std::map<uint16_t, uint64_t> &value) {
+            put_uint32(static_cast<uint32_t>(value.size() * 10));
+            for (const auto &[key, val]: value) {
+                put_uint16(key);
+                put_uint64(val);
+            }
+        }
+
+        // Writes the record followed by an unprefixed payload (message data, chunk records).
+        // Returns the total number of bytes written, including opcode and length.
+        uint64_t write(std::ostream &dst, McapOpcode opcode, const char *payload = nullptr, size_t payloadSize = 0) const {
+            auto op = static_cast<char>(opcode);
+            dst.write(&op, 1);
+            uint64_t length = content.size() + payloadSize;
+            dst.write(reinterpret_cast<const char *>(serialize_uint64(length).data()), 8);
+            dst.write(reinterpret_cast<const char *>(content.data()), static_cast<std::streamsize>(content.size()));
+            if (payloadSize > 0)
+                dst.write(payload, static_cast<std::streamsize>(payloadSize));
+            return 9 + length;
+        }
+    };
+
+    // MCAP container using the ros1 profile, so the chunks carry the same ros1msg serialized payloads.
+    class McapBackend : public StorageBackend {
+    public:
+        void writeHeader(std::ostream &bio) override;
+        void writeConnection(const Connection &connection, std::ostream &dst) override;
+        void writeMessage(const Connection &connection, int64_t timestamp, const std::vector<uint8_t> &data,
+                          std::ostream &dst) override;
+        void encodeChunk(const WriteChunk &chunk, EncodedChunk &encoded) const override;
+        void writeEncodedChunk(WriteChunk &chunk, const EncodedChunk &encoded, std::ostream &bio) override;
+        void writeIndex(const std::vector<Connection> &connections, const std::vector<ChunkSummary> &chunks,
+                        std::ostream &bio) override;
+        bool supportsCompression(CompressionType type) const override;
+
+    private:
+        struct ChunkIndex {
+            uint64_t start;
+            uint64_t end;
+            uint64_t chunkStart;
+            uint64_t chunkLength;
+            std::map<uint16_t, uint64_t> messageIndexOffsets;
+            uint64_t messageIndexLength;
+            std::string compression;
+            uint64_t compressedSize;
+            uint64_t uncompressedSize;
+        };
+
+        std::map<std::string, uint16_t> schemaIds;
+        std::unordered_map<int, uint32_t> sequences;
+        std::vector<ChunkIndex> chunkIndexes;
+
+        uint16_t schemaId(const Connection &connection);
+        void writeSchema(const Connection &connection, std::ostream &dst);
+        void writeChannel(const Connection &connection, std::ostream &dst);
+    };
+
+}
+
+#endif // ROSBAGWRITER_MCAPBACKEND_H
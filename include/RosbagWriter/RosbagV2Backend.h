@@ -0,0 +1,29 @@
+#ifndef ROSBAGWRITER_ROSBAGV2BACKEND_H
+#define ROSBAGWRITER_ROSBAGV2BACKEND_H
+
+#include <RosbagWriter/StorageBackend.h>
+
+namespace CRLRosWriter {
+
+    // ROS 1 bag format version 2.0 (http://wiki.ros.org/Bags/Format/2.0)
+    class RosbagV2Backend : public StorageBackend {
+    public:
+        void writeHeader(std::ostream &bio) override;
+        void writeConnection(const Connection &connection, std::ostream &dst) override;
+        void writeMessage(const Connection &connection, int64_t timestamp, const std::vector<uint8_t> &data,
+                          std::ostream &dst) override;
+        void writeIndex(const std::vector<Connection> &connections, const std::vector<ChunkSummary> &chunks,
+                        std::ostream &bio) override;
+        bool supportsCompression(CompressionType type) const override;
+        // Chunk sizes and message offsets are uint32 fields
+        uint64_t maxChunkSize() const override { return std::numeric_limits<uint32_t>::max(); }
+        void encodeChunk(const WriteChunk &chunk, EncodedChunk &encoded) const override;
+        void writeEncodedChunk(WriteChunk &chunk, const EncodedChunk &encoded, std::ostream &bio) override;
+
+    private:
+        void writeBagHeader(std::ostream &bio, uint64_t indexPos, uint32_t connCount, uint32_t chunkCount);
+    };
+
+}
+
+#endif // ROSBAGWRITER_ROSBAGV2BACKEND_H
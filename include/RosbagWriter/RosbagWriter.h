@@ -2,37 +2,88 @@
 #define ROSBAGWRITER_WRITER_H
 
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
+#include <map>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <fstream>
 
 #include <RosbagWriter/Header.h>
 #include <RosbagWriter/utils.h>
+#include <RosbagWriter/StorageBackend.h>
+#include <RosbagWriter/TimeIndexFormat.h>
 
 namespace CRLRosWriter {
 
-    struct WriteChunk {
-        std::ostringstream data;
-        int64_t pos;
-        int64_t start;
-        int64_t end;
-        std::unordered_map<int, std::vector<std::pair<int64_t, int>>> connections;
-
-        WriteChunk() : pos(-1), start(INT_MAX), end(0) {
-            data = std::ostringstream(std::ios::binary);
-        }
+    // Estimated memory held by a RosbagWriter, see RosbagWriter::setMemoryBudget()
+    struct MemoryUsage {
+        uint64_t budget = 0;
+        uint64_t chunkBuffer = 0;     // open chunk, including the copies made while it is encoded
+        uint64_t index = 0;           // chunk records, offsets of the open chunk and time index entries in memory
+        uint64_t peak = 0;
+        uint64_t earlySeals = 0;      // chunks written below the chunk threshold to stay within the budget
+        uint64_t spilledEntries = 0;  // time index entries moved to the scratch file
+        bool unattainable = false;    // the index alone left no room for a minimum size chunk
+
+        uint64_t total() const { return chunkBuffer + index; }
     };
 
     class RosbagWriter {
     public:
-        explicit RosbagWriter() : chunk_threshold(20 * (1 << 20)) {
-            chunks.emplace_back();
-
+        explicit RosbagWriter(StorageFormat format = StorageFormat::ROSBAG_V2) : chunk_threshold(20 * (1 << 20)),
+                                                                              backend(createStorageBackend(format)) {
+        }
+        // Writes through a caller provided backend, e.g. one derived from RosbagV2Backend.
+        explicit RosbagWriter(std::unique_ptr<StorageBackend> storage) : chunk_threshold(20 * (1 << 20)),
+                                                                         backend(std::move(storage)) {
         }
 
         Connection add_connection(const std::string &topic, const std::string &msg_type);
         void write(Connection &connection, int64_t timestamp, std::vector<uint8_t> data);
         Connection getConnection(const std::string &topic, const std::string &msgType);
+        // Must be called before open(). Falls back to uncompressed chunks if the codec is not available.
+        bool setCompression(CompressionType type);
+        // Thresholds the storage format cannot describe (4 GiB and up for ROS bag v2) are clamped, returns false then.
+        bool setChunkThreshold(uint64_t bytes);
+        // Large-bag mode: reserve file extents in steps of this many bytes (fallocate on Linux) as the recording
+        // grows, so long recordings are not fragmented. The unused tail is released in close(). 0 disables.
+        void setPreallocation(uint64_t bytes) { preallocation = bytes; }
+        // Also write <bag>.tidx on close, a per-connection sorted (time, chunk_pos, offset) index for
+        // CRLRosReader::TimeIndex.
+        void setTimeIndex(bool enable) { time_index = enable; }
+        // Target in bytes for the memory the writer holds, 0 (default) for none. When the open chunk would not fit
+        // next to the index the chunk is written out early, but never below min(64 KiB, chunk threshold); with
+        // setTimeIndex(true) the time index entries of written chunks move to <bag>.tidx.spill until close.
+        // The accounting is an estimate of the writer's own buffers (see MemoryUsage), not measured memory. If the
+        // per-chunk index records of a long recording outgrow the budget, MemoryUsage::unattainable is set and a
+        // warning printed instead of shrinking chunks further.
+        void setMemoryBudget(uint64_t bytes) { memory_budget = bytes; }
+        // Safe to call from any thread while recording.
+        MemoryUsage getMemoryUsage() const;
+
+        // Durability mode, must be called before open(). A commit thread seals the open chunk, flushes it and
+        // syncs the bag (fdatasync, F_FULLFSYNC on macOS) at most maxDelay after the first pending writeDurable(); every durable write that
+        // arrived in the meantime shares that one sync (group commit). Plain write() calls are not delayed.
+        // Every commit ends the open chunk, so the chunk size is bounded by what arrives within maxDelay rather than
+        // by the chunk threshold: a steady stream of durable writes with a 1 ms delay produces up to 1000 small
+        // chunks per second, each with its own IDXDATA and CHUNK_INFO records, and compresses poorly. Pick the
+        // largest delay the application can tolerate. On platforms without fsync durable writes complete with false.
+        void setDurability(std::chrono::microseconds maxDelay);
+
+        // Like write(), completes with true once the chunk holding the message is on disk, false on an I/O error or
+        // if the message was dropped for exceeding the chunk size limit of the format.
+        std::future<bool> writeDurable(Connection &connection, int64_t timestamp, std::vector<uint8_t> data);
+        // Callback variant, onDurable runs on the commit thread and must not call back into the writer.
+        void writeDurable(Connection &connection, int64_t timestamp, std::vector<uint8_t> data,
+                          std::function<void(bool)> onDurable);
+        // Number of syncs issued by the commit thread so far.
+        uint64_t getSyncCount() const { return sync_count; }
 
         std::vector<uint8_t>
         serializeImage(uint32_t sequence, int64_t timestamp, uint32_t width, uint32_t height, uint8_t *pData, uint32_t dataSize,
@@ -51,20 +102,67 @@ namespace CRLRosWriter {
         bool opened = false;
         std::fstream bio;
         std::filesystem::path path;
-        std::vector<int> message_offsets;
         std::vector<Connection> connections;
-        std::vector<WriteChunk> chunks;
-        int chunk_threshold;
-
-
-        void write_connection(const Connection &connection, std::ostream &bio);
-
-
-        void write_chunk(WriteChunk &chunk);
+        WriteChunk chunk;                   // open chunk
+        std::vector<ChunkSummary> written;  // index records of the chunks on disk
+        size_t sealed_chunks = 0;           // the open chunk is chunk number sealed_chunks
+        uint64_t chunk_threshold;
+        std::unique_ptr<StorageBackend> backend;
+        int fd = -1;
+        uint64_t preallocation = 0;
+        uint64_t allocated = 0;
+        bool time_index = false;
+
+        struct DurableWrite {
+            size_t chunk;   // number of the chunk holding the message, see sealed_chunks
+            std::function<void(bool)> done;
+        };
+        // Guards connections, the chunk state, bio and the memory accounting. write_chunk() releases it while the
+        // sealed chunk is compressed; sealing is set meanwhile so the next chunk waits for its turn.
+        mutable std::mutex mutex;
+        std::condition_variable commit_cv;
+        std::condition_variable sealed_cv;
+        bool sealing = false;
+        uint64_t in_flight = 0;   // estimated cost of the chunk being encoded, part of usage.chunkBuffer
+        std::vector<DurableWrite> pending;
+        std::chrono::steady_clock::time_point first_pending;
+        std::chrono::microseconds commit_delay{0};
+        std::thread committer;
+        bool durable = false;
+        bool stop_commit = false;
+        int sync_fd = -1;
+        std::atomic<uint64_t> sync_count{0};
+
+        struct SpilledRun {
+            uint64_t offset;  // in the spill file
+            uint64_t count;
+        };
+        uint64_t memory_budget = 0;
+        MemoryUsage usage;
+        std::fstream spill;
+        bool spill_failed = false;
+        std::map<int, std::vector<SpilledRun>> spilled_runs;
+        std::map<int, std::vector<TimeIndexEntry>> time_entries; // of written chunks, not spilled yet
+
+        uint64_t chunk_cost(uint64_t size) const;
+        uint64_t min_chunk_size() const;
+        void release_chunk(const WriteChunk &sealed);
+        void spill_index();
+
+        // Returns false if the message was dropped, otherwise chunk_index is the number of the chunk that holds it
+        bool append(std::unique_lock<std::mutex> &lock, Connection &connection, int64_t timestamp,
+                    const std::vector<uint8_t> &data, size_t &chunk_index);
+        void commit_loop();
+        bool sync();
+
+        void write_chunk(std::unique_lock<std::mutex> &lock);
+        Connection register_connection(const std::string &topic, const std::string &msg_type);
+        void preallocate(uint64_t end);
+        void releasePreallocation();
+        void write_time_index();
 
         void close();
 
-        void writeHeader();
         std::vector<uint8_t> serializerRosHeader(uint32_t sequence, int64_t currentTimeNs);
 
     };
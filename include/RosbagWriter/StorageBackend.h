@@ -0,0 +1,112 @@
+#ifndef ROSBAGWRITER_STORAGEBACKEND_H
+#define ROSBAGWRITER_STORAGEBACKEND_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <RosbagWriter/Header.h>
+#include <RosbagWriter/Compression.h>
+
+namespace CRLRosWriter {
+
+    enum class StorageFormat : int {
+        ROSBAG_V2 = 0,
+        MCAP = 1
+    };
+
+    // Upper bound of the record framing a backend adds around message data in a chunk
+    constexpr uint64_t MESSAGE_RECORD_OVERHEAD = 4096;
+
+    // What the index section needs of a written chunk. Kept for every chunk until the bag is closed, so it holds
+    // no buffers or offsets.
+    struct ChunkSummary {
+        int64_t pos = -1;
+        int64_t start = std::numeric_limits<int64_t>::max();
+        int64_t end = 0;
+        std::vector<std::pair<int, uint64_t>> counts; // connection id, messages; sorted by id
+    };
+
+    struct WriteChunk {
+        std::ostringstream data;
+        int64_t pos;
+        int64_t start;
+        int64_t end;
+        std::unordered_map<int, std::vector<std::pair<int64_t, uint64_t>>> connections; // timestamp, offset in chunk
+
+        WriteChunk() : pos(-1), start(std::numeric_limits<int64_t>::max()), end(0) {
+            data = std::ostringstream(std::ios::binary);
+        }
+
+        ChunkSummary summary() const {
+            ChunkSummary summary{pos, start, end, {}};
+            summary.counts.reserve(connections.size());
+            for (const auto &[cid, items]: connections)
+                summary.counts.emplace_back(cid, items.size());
+            std::sort(summary.counts.begin(), summary.counts.end());
+            return summary;
+        }
+    };
+
+    // Container encoding used by RosbagWriter. The writer owns connection bookkeeping, chunk buffering and the
+    // per-connection message offsets; a backend only decides how records are laid out in the chunk and the file.
+    class StorageBackend {
+    public:
+        virtual ~StorageBackend() = default;
+
+        // Called once after the file is opened.
+        virtual void writeHeader(std::ostream &bio) = 0;
+
+        // Connection/schema records are written once, into the chunk that is open when the connection is added;
+        // later chunks are not self describing. Readers find all connections in the index (ROS bag v2) or
+        // summary (MCAP) section.
+        virtual void writeConnection(const Connection &connection, std::ostream &dst) = 0;
+
+        virtual void writeMessage(const Connection &connection, int64_t timestamp, const std::vector<uint8_t> &data,
+                                  std::ostream &dst) = 0;
+
+        // Writes chunk.data (and its message index) to the file and sets chunk.pos.
+        void writeChunk(WriteChunk &chunk, std::ostream &bio) {
+            EncodedChunk encoded;
+            encodeChunk(chunk, encoded);
+            writeEncodedChunk(chunk, encoded, bio);
+        }
+
+        // writeChunk() in two steps so a chunk can be compressed without holding the writer lock, or on other
+        // threads, and still be written in order. encodeChunk() only reads the chunk and the compression setting.
+        struct EncodedChunk {
+            CompressionType type = CompressionType::NONE;
+            uint64_t size = 0;      // uncompressed size
+            std::string payload;
+        };
+        virtual void encodeChunk(const WriteChunk &chunk, EncodedChunk &encoded) const = 0;
+        virtual void writeEncodedChunk(WriteChunk &chunk, const EncodedChunk &encoded, std::ostream &bio) = 0;
+
+        // Writes the index/summary section once all chunks have been written.
+        virtual void writeIndex(const std::vector<Connection> &connections, const std::vector<ChunkSummary> &chunks,
+                                std::ostream &bio) = 0;
+
+        virtual bool supportsCompression(CompressionType type) const = 0;
+
+        // Largest chunk, compressed or not, the container can describe.
+        virtual uint64_t maxChunkSize() const { return std::numeric_limits<uint64_t>::max(); }
+
+        void setCompression(CompressionType type) { compression = type; }
+        CompressionType getCompression() const { return compression; }
+
+    protected:
+        CompressionType compression = CompressionType::NONE;
+    };
+
+    std::unique_ptr<StorageBackend> createStorageBackend(StorageFormat format);
+
+}
+
+#endif // ROSBAGWRITER_STORAGEBACKEND_H
@@ -0,0 +1,88 @@
+#ifndef ROSBAGWRITER_STRIPEDWRITER_H
+#define ROSBAGWRITER_STRIPEDWRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <RosbagWriter/RosbagWriter.h>
+
+namespace CRLRosWriter {
+
+    // Spreads connections over one RosbagWriter per output directory (typically one per disk). Every stripe is a
+    // valid standalone bag; each has its own I/O thread so chunk flushes to different devices run in parallel.
+    // close() writes <first directory>/<name>.stripes with a global time index over all stripes, see
+    // CRLRosReader::StripeManifest.
+    // getConnection() and write() may be called from several producer threads; open() and close() may not run
+    // concurrently with them. After close() writes are dropped until the next open().
+    class StripedWriter {
+    public:
+        StripedWriter() = default;
+        StripedWriter(const StripedWriter &) = delete;
+        StripedWriter &operator=(const StripedWriter &) = delete;
+
+        ~StripedWriter() {
+            close();
+        }
+
+        // Creates <directory>/<name>_<i>.bag for each directory.
+        void open(const std::vector<std::filesystem::path> &directories, const std::string &name);
+
+        // New topics are assigned to stripes round robin, or to the given stripe.
+        Connection getConnection(const std::string &topic, const std::string &msgType);
+        Connection getConnection(const std::string &topic, const std::string &msgType, size_t stripe);
+
+        // Queues the message on the connection's stripe. Blocks while that stripe has more than
+        // queue_limit bytes waiting, so a slow disk applies back pressure instead of growing memory.
+        void write(Connection &connection, int64_t timestamp, std::vector<uint8_t> data);
+
+        void close();
+
+        void setChunkThreshold(uint64_t bytes) { chunk_threshold = bytes; }
+        void setQueueLimit(uint64_t bytes) { queue_limit = bytes; }
+
+        const std::vector<std::filesystem::path> &getStripePaths() const { return stripe_paths; }
+        const std::filesystem::path &getManifestPath() const { return manifest_path; }
+
+    private:
+        struct Message {
+            Connection *connection; // stripe local connection, owned by connections
+            int64_t timestamp;
+            std::vector<uint8_t> data;
+        };
+
+        struct Stripe {
+            std::unique_ptr<RosbagWriter> writer; // synchronizes itself
+            std::mutex mutex; // guards queue, queued and stop
+            std::condition_variable cv;
+            std::deque<Message> queue;
+            uint64_t queued = 0;
+            bool stop = false;
+            std::thread thread;
+        };
+
+        void run(Stripe &stripe);
+
+        Connection add_connection(const std::string &topic, const std::string &msgType, size_t stripe);
+
+        std::vector<std::unique_ptr<Stripe>> stripes;
+        std::shared_mutex connections_mutex; // guards connections, next_stripe and opened
+        // global id -> stripe, stripe local connection; a deque so queued messages can point into it while new
+        // connections are added
+        std::deque<std::pair<size_t, Connection>> connections;
+        std::vector<std::filesystem::path> stripe_paths;
+        std::filesystem::path manifest_path;
+        size_t next_stripe = 0;
+        uint64_t chunk_threshold = 20 * (1 << 20);
+        uint64_t queue_limit = 64 * (1 << 20);
+        bool opened = false;
+    };
+
+}
+
+#endif // ROSBAGWRITER_STRIPEDWRITER_H
@@ -0,0 +1,42 @@
+#ifndef ROSBAGWRITER_TIMEINDEXFORMAT_H
+#define ROSBAGWRITER_TIMEINDEXFORMAT_H
+
+#include <cstdint>
+
+namespace CRLRosWriter {
+
+    // On-disk layout of the per-connection time index sidecar (<bag>.tidx), little endian and 8-byte aligned
+    // throughout so a reader can mmap it and use the arrays in place:
+    //
+    //   TimeIndexFileHeader
+    //   TimeIndexDirectoryEntry[connCount]   sorted by conn
+    //   TimeIndexEntry[...]                  one run per connection, sorted by time
+    static constexpr char TIME_INDEX_MAGIC[8] = {'R', 'B', 'T', 'I', 'D', 'X', '0', '1'};
+
+    struct TimeIndexFileHeader {
+        char magic[8];
+        uint32_t connCount;
+        uint32_t reserved;
+        uint64_t bagSize;   // size of the bag the index was written for, to detect a stale sidecar
+    };
+
+    struct TimeIndexDirectoryEntry {
+        uint32_t conn;
+        uint32_t reserved;
+        uint64_t offset;    // byte offset of the first TimeIndexEntry of this connection
+        uint64_t count;
+    };
+
+    struct TimeIndexEntry {
+        int64_t time;
+        uint64_t chunkPos;  // file offset of the chunk record
+        uint64_t offset;    // offset of the message record inside the uncompressed chunk
+    };
+
+    static_assert(sizeof(TimeIndexFileHeader) == 24, "unexpected padding in TimeIndexFileHeader");
+    static_assert(sizeof(TimeIndexDirectoryEntry) == 24, "unexpected padding in TimeIndexDirectoryEntry");
+    static_assert(sizeof(TimeIndexEntry) == 24, "unexpected padding in TimeIndexEntry");
+
+}
+
+#endif // ROSBAGWRITER_TIMEINDEXFORMAT_H
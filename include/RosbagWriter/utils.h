@@ -2,6 +2,7 @@
 #define ROSBAGWRITER_UTILS_H
 
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -0,0 +1,270 @@
+//
+// Multi-bag dataset over split recordings.
+//
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <iostream>
+#include <thread>
+
+#include "RosbagReader/BagDataset.h"
+
+namespace CRLRosReader {
+
+    // Orders digit runs by value so that run_2.bag sorts before run_10.bag
+    static bool naturalLess(const std::string &a, const std::string &b) {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size()) {
+            if (std::isdigit(static_cast<unsigned char>(a[i])) && std::isdigit(static_cast<unsigned char>(b[j]))) {
+                size_t iEnd = i, jEnd = j;
+                while (iEnd < a.size() && std::isdigit(static_cast<unsigned char>(a[iEnd]))) ++iEnd;
+                while (jEnd < b.size() && std::isdigit(static_cast<unsigned char>(b[jEnd]))) ++jEnd;
+                std::string x = a.substr(i, iEnd - i), y = b.substr(j, jEnd - j);
+                x.erase(0, std::min(x.find_first_not_of('0'), x.size()));
+                y.erase(0, std::min(y.find_first_not_of('0'), y.size()));
+                if (x.size() != y.size())
+                    return x.size() < y.size();
+                if (x != y)
+                    return x < y;
+                i = iEnd;
+                j = jEnd;
+            } else {
+                if (a[i] != b[j])
+                    return a[i] < b[j];
+                ++i;
+                ++j;
+            }
+        }
+        return a.size() - i < b.size() - j;
+    }
+
+    bool BagDataset::openDirectory(const std::filesystem::path &directory, unsigned threads) {
+        std::error_code ec;
+        std::vector<std::filesystem::path> found;
+        for (const auto &entry: std::filesystem::directory_iterator(directory, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".bag")
+                found.push_back(entry.path());
+        }
+        if (ec || found.empty()) {
+            std::cerr << "Error: no bags found in " << directory << std::endl;
+            return false;
+        }
+        std::sort(found.begin(), found.end(), [](const std::filesystem::path &a, const std::filesystem::path &b) {
+            return naturalLess(a.filename().string(), b.filename().string());
+        });
+        return open(found, threads);
+    }
+
+    bool BagDataset::open(const std::vector<std::filesystem::path> &bagPaths, unsigned threads) {
+        bags = bagPaths;
+        connections.clear();
+        chunks.clear();
+        files.clear();
+        connectionIds.assign(bags.size(), {});
+        bagSummaries.assign(bags.size(), {});
+
+        // Index sections are read in parallel, each reader is closed again before the next bag is taken
+        std::vector<std::vector<ConnectionInfo>> bagConnections(bags.size());
+        std::vector<std::vector<ChunkInfo>> bagChunks(bags.size());
+        std::vector<char> ok(bags.size(), 0);
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < bags.size(); i = next++) {
+                RosbagReader reader;
+                if (!reader.open(bags[i]) || !reader.readHeader())
+                    continue;
+                bagSummaries[i] = reader.summary();
+                bagConnections[i] = reader.getConnections();
+                bagChunks[i] = reader.getChunks();
+                ok[i] = 1;
+            }
+        };
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<unsigned>(std::min<size_t>({threads, maxOpenFiles, bags.size()}));
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back(worker);
+        worker();
+        for (auto &thread: workers)
+            thread.join();
+
+        for (size_t i = 0; i < bags.size(); ++i) {
+            if (!ok[i]) {
+                std::cerr << "Error: could not read the index of " << bags[i] << std::endl;
+                return false;
+            }
+        }
+
+        // Merge connections by topic, type and md5sum, then translate the chunk counts to dataset ids
+        for (size_t i = 0; i < bags.size(); ++i) {
+            for (const ConnectionInfo &info: bagConnections[i]) {
+                auto it = std::find_if(connections.begin(), connections.end(), [&](const DatasetConnection &c) {
+                    return c.topic == info.topic && c.msgType == info.msgType && c.md5sum == info.md5sum;
+                });
+                if (it == connections.end()) {
+                    connections.push_back({static_cast<uint32_t>(connections.size()), info.topic, info.msgType,
+                                           info.md5sum, info.msgDef});
+                    it = connections.end() - 1;
+                }
+                connectionIds[i][info.id] = it->id;
+            }
+            for (const ChunkInfo &info: bagChunks[i]) {
+                DatasetChunk chunk;
+                chunk.bag = static_cast<uint32_t>(i);
+                chunk.pos = info.pos;
+                chunk.start = info.start;
+                chunk.end = info.end;
+                for (const auto &[conn, count]: info.messageCounts) {
+                    auto id = connectionIds[i].find(conn);
+                    if (id != connectionIds[i].end())
+                        chunk.messageCounts[id->second] += count;
+                }
+                chunks.push_back(std::move(chunk));
+            }
+        }
+        std::stable_sort(chunks.begin(), chunks.end(), [](const DatasetChunk &a, const DatasetChunk &b) {
+            return a.start < b.start;
+        });
+        return true;
+    }
+
+    BagSummary BagDataset::summary() const {
+        BagSummary summary;
+        summary.path = bags.empty() ? std::filesystem::path() : bags.front().parent_path();
+        bool first = true;
+        for (const BagSummary &bag: bagSummaries) {
+            summary.fileSize += bag.fileSize;
+            summary.chunkCount += bag.chunkCount;
+            if (bag.messageCount > 0) {
+                summary.start = first ? bag.start : std::min(summary.start, bag.start);
+                summary.end = first ? bag.end : std::max(summary.end, bag.end);
+                first = false;
+            }
+            summary.messageCount += bag.messageCount;
+            for (const TopicInfo &topic: bag.topics) {
+                auto it = std::find_if(summary.topics.begin(), summary.topics.end(), [&](const TopicInfo &t) {
+                    return t.topic == topic.topic && t.msgType == topic.msgType;
+                });
+                if (it == summary.topics.end()) {
+                    summary.topics.push_back({topic.topic, topic.msgType, 0, 0});
+                    it = summary.topics.end() - 1;
+                }
+                it->messageCount += topic.messageCount;
+                it->connections = std::max(it->connections, topic.connections);
+            }
+        }
+        std::sort(summary.topics.begin(), summary.topics.end(), [](const TopicInfo &a, const TopicInfo &b) {
+            return a.topic < b.topic;
+        });
+        return summary;
+    }
+
+    std::vector<const DatasetChunk *> BagDataset::query(int64_t start, int64_t end,
+                                                        const std::vector<std::string> &topics) const {
+        std::vector<bool> selected(connections.size(), topics.empty());
+        for (const DatasetConnection &connection: connections) {
+            if (std::find(topics.begin(), topics.end(), connection.topic) != topics.end())
+                selected[connection.id] = true;
+        }
+
+        std::vector<const DatasetChunk *> result;
+        auto last = std::upper_bound(chunks.begin(), chunks.end(), end, [](int64_t time, const DatasetChunk &chunk) {
+            return time < chunk.start;
+        });
+        for (auto it = chunks.begin(); it != last; ++it) {
+            if (it->end < start)
+                continue;
+            if (std::any_of(it->messageCounts.begin(), it->messageCounts.end(), [&](const auto &count) {
+                return count.second > 0 && selected[count.first];
+            }))
+                result.push_back(&*it);
+        }
+        return result;
+    }
+
+    RosbagReader *BagDataset::acquire(uint32_t bag) {
+        auto it = std::find_if(files.begin(), files.end(), [bag](const OpenFile &file) { return file.bag == bag; });
+        if (it == files.end()) {
+            if (files.size() >= maxOpenFiles) {
+                it = std::min_element(files.begin(), files.end(), [](const OpenFile &a, const OpenFile &b) {
+                    return a.lastUse < b.lastUse;
+                });
+                it->reader.reset();
+            } else {
+                files.emplace_back();
+                it = files.end() - 1;
+            }
+            it->bag = bag;
+            it->reader = std::make_unique<RosbagReader>();
+            if (!it->reader->open(bags[bag])) {
+                files.erase(it);
+                return nullptr;
+            }
+        }
+        it->lastUse = ++useCounter;
+        return it->reader.get();
+    }
+
+    bool BagDataset::readChunk(const DatasetChunk &chunk, std::vector<uint8_t> &data) {
+        RosbagReader *reader = acquire(chunk.bag);
+        ChunkRecord record;
+        if (!reader || !reader->readChunk(chunk.pos, record) || !decompressChunk(record))
+            return false;
+        data = std::move(record.data);
+        return true;
+    }
+
+    BagDataset::Cursor BagDataset::messages(int64_t start, int64_t end, const std::vector<std::string> &topics) {
+        Cursor cursor;
+        cursor.dataset = this;
+        cursor.start = start;
+        cursor.end = end;
+        cursor.selected.assign(connections.size(), topics.empty());
+        for (const DatasetConnection &connection: connections) {
+            if (std::find(topics.begin(), topics.end(), connection.topic) != topics.end())
+                cursor.selected[connection.id] = true;
+        }
+        cursor.chunks = query(start, end, topics);
+        return cursor;
+    }
+
+    void BagDataset::Cursor::load(const DatasetChunk &chunk) {
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        if (!dataset->readChunk(chunk, *data) || !parseMessages(*data, records)) {
+            std::cerr << "Error: could not read chunk at " << chunk.pos << " of " << dataset->bags[chunk.bag]
+                      << std::endl;
+            error = true;
+            return;
+        }
+        const auto &ids = dataset->connectionIds[chunk.bag];
+        for (const MessageRecord &record: records) {
+            auto id = ids.find(record.conn);
+            if (id == ids.end() || !selected[id->second] || record.time < start || record.time > end)
+                continue;
+            heap.push({record.time, order++, id->second, chunk.bag, data, record.begin, record.end});
+        }
+    }
+
+    bool BagDataset::Cursor::next(DatasetMessage &message) {
+        if (!dataset)
+            return false;
+        // A chunk can only hold messages at or after its start time, so every chunk starting before the current
+        // earliest message has to be loaded before that message can be returned.
+        while (nextChunk < chunks.size() && (heap.empty() || chunks[nextChunk]->start <= heap.top().time))
+            load(*chunks[nextChunk++]);
+        if (heap.empty())
+            return false;
+
+        const Pending &top = heap.top();
+        message.connection = &dataset->connections[top.conn];
+        message.bag = top.bag;
+        message.time = top.time;
+        message.chunk = top.chunk;
+        message.begin = top.begin;
+        message.end = top.end;
+        heap.pop();
+        return true;
+    }
+
+}
@@ -0,0 +1,417 @@
+//
+// Parallel export of image and scalar topics.
+//
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef ROSBAG_WRITER_WITH_PNG
+#include <png.h>
+#endif
+
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/MessageDecoders.h"
+#include "RosbagReader/BagExport.h"
+
+namespace CRLRosReader {
+
+    namespace {
+        enum class ExportKind {
+            NONE,
+            IMAGE,
+            SCALAR
+        };
+
+        struct ConnectionExport {
+            ExportKind kind = ExportKind::NONE;
+            size_t topic = 0;
+            const ScalarDecoder *decoder = nullptr;
+        };
+
+        struct TopicOutput {
+            std::string topic;
+            std::string name;   // file or directory name in the output directory
+            ExportKind kind = ExportKind::NONE;
+            const ScalarDecoder *decoder = nullptr;
+            std::ofstream file;
+        };
+
+        // Scalar rows produced from one chunk, per topic
+        struct ChunkOutput {
+            bool ready = false;
+            std::vector<std::string> rows;
+            std::vector<std::string> layout; // binary mode: column list of the first row
+        };
+    }
+
+    static std::string topicFileName(const std::string &topic) {
+        size_t first = topic.find_first_not_of('/');
+        std::string name = first == std::string::npos ? std::string() : topic.substr(first);
+        std::replace(name.begin(), name.end(), '/', '_');
+        return name.empty() ? "root" : name;
+    }
+
+    static bool imageFormat(const std::string &encoding, int &channels, int &depth, bool &bgr) {
+        bgr = encoding == "bgr8" || encoding == "bgra8";
+        if (encoding == "mono8" || encoding == "8UC1" || encoding.rfind("bayer_", 0) == 0)
+            channels = 1, depth = 8;
+        else if (encoding == "mono16" || encoding == "16UC1")
+            channels = 1, depth = 16;
+        else if (encoding == "rgb8" || encoding == "bgr8")
+            channels = 3, depth = 8;
+        else if (encoding == "rgba8" || encoding == "bgra8")
+            channels = 4, depth = 8;
+        else
+            return false;
+        return true;
+    }
+
+#ifdef ROSBAG_WRITER_WITH_PNG
+    static bool writeImage(const ImageMessage &image, const std::filesystem::path &path, int level,
+                           uint64_t &written) {
+        int channels = 0, depth = 0;
+        bool bgr = false;
+        if (!imageFormat(image.encoding, channels, depth, bgr) ||
+            image.step < static_cast<uint64_t>(image.width) * channels * depth / 8)
+            return false;
+
+        FILE *file = std::fopen((path.string() + ".png").c_str(), "wb");
+        if (!file)
+            return false;
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        png_infop info = png ? png_create_info_struct(png) : nullptr;
+        std::vector<png_bytep> rows(image.height);
+        for (uint32_t y = 0; y < image.height; ++y)
+            rows[y] = const_cast<png_bytep>(image.data + static_cast<size_t>(y) * image.step);
+
+        volatile bool ok = false;
+        if (info && setjmp(png_jmpbuf(png)) == 0) {
+            static const int colorTypes[] = {0, PNG_COLOR_TYPE_GRAY, 0, PNG_COLOR_TYPE_RGB, PNG_COLOR_TYPE_RGBA};
+            png_init_io(png, file);
+            png_set_compression_level(png, level);
+            png_set_filter(png, 0, level <= 1 ? PNG_FILTER_NONE : PNG_ALL_FILTERS);
+            png_set_IHDR(png, info, image.width, image.height, depth, colorTypes[channels], PNG_INTERLACE_NONE,
+                         PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+            png_write_info(png, info);
+            if (bgr)
+                png_set_bgr(png);
+            if (depth == 16 && !image.isBigEndian)
+                png_set_swap(png);
+            png_write_image(png, rows.data());
+            png_write_end(png, nullptr);
+            ok = true;
+        }
+        png_destroy_write_struct(&png, info ? &info : nullptr);
+        long size = std::ftell(file);
+        ok = std::fclose(file) == 0 && ok;
+        written += size > 0 ? static_cast<uint64_t>(size) : 0;
+        return ok;
+    }
+#else
+    // Without libpng images are written as binary PGM/PPM, alpha channels are not supported
+    static bool writeImage(const ImageMessage &image, const std::filesystem::path &path, int, uint64_t &written) {
+        int channels = 0, depth = 0;
+        bool bgr = false;
+        if (!imageFormat(image.encoding, channels, depth, bgr) || channels == 4 ||
+            image.step < static_cast<uint64_t>(image.width) * channels * depth / 8)
+            return false;
+
+        std::ofstream file(path.string() + (channels == 1 ? ".pgm" : ".ppm"), std::ios::binary);
+        file << (channels == 1 ? "P5" : "P6") << "\n" << image.width << " " << image.height << "\n"
+             << (depth == 16 ? 65535 : 255) << "\n";
+        // PNM samples are big endian
+        bool swap = depth == 16 && !image.isBigEndian;
+        std::vector<uint8_t> row(static_cast<size_t>(image.width) * channels * depth / 8);
+        for (uint32_t y = 0; y < image.height; ++y) {
+            std::memcpy(row.data(), image.data + static_cast<size_t>(y) * image.step, row.size());
+            for (size_t i = 0; bgr && i + 2 < row.size(); i += 3)
+                std::swap(row[i], row[i + 2]);
+            for (size_t i = 0; swap && i + 1 < row.size(); i += 2)
+                std::swap(row[i], row[i + 1]);
+            file.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+        }
+        written += static_cast<uint64_t>(file.tellp());
+        return static_cast<bool>(file);
+    }
+#endif
+
+    static void appendCsv(std::string &out, int64_t time, const std::vector<FieldValue> &row) {
+        std::ostringstream line;
+        line << std::setprecision(std::numeric_limits<double>::max_digits10) << time;
+        for (const FieldValue &value: row) {
+            line << ",";
+            if (auto integer = std::get_if<int64_t>(&value)) {
+                line << *integer;
+            } else if (auto real = std::get_if<double>(&value)) {
+                line << *real;
+            } else {
+                line << '"';
+                for (char c: std::get<std::string>(value))
+                    line << (c == '"' ? "\"\"" : std::string(1, c));
+                line << '"';
+            }
+        }
+        line << "\n";
+        out += line.str();
+    }
+
+    static void appendBinary(std::string &out, int64_t time, const std::vector<FieldValue> &row) {
+        auto put = [&out](const void *value) {
+            out.append(static_cast<const char *>(value), 8);
+        };
+        put(&time);
+        for (const FieldValue &value: row) {
+            if (auto integer = std::get_if<int64_t>(&value))
+                put(integer);
+            else if (auto real = std::get_if<double>(&value))
+                put(real);
+        }
+    }
+
+    static std::string binaryLayout(const ScalarDecoder &decoder, const std::vector<FieldValue> &row) {
+        std::string layout = "time int64\n";
+        for (size_t i = 0; i < row.size() && i < decoder.columns.size(); ++i) {
+            if (std::holds_alternative<int64_t>(row[i]))
+                layout += decoder.columns[i] + " int64\n";
+            else if (std::holds_alternative<double>(row[i]))
+                layout += decoder.columns[i] + " float64\n";
+        }
+        return layout;
+    }
+
+    bool exportBag(const std::filesystem::path &filePath, const ExportOptions &options, ExportResult &result) {
+        result = ExportResult();
+        RosbagReader index;
+        if (!index.open(filePath) || !index.readHeader())
+            return false;
+
+        // Pick the connections to export and the decoder for each
+        std::vector<TopicOutput> topics;
+        std::vector<ConnectionExport> exports;
+        for (const ConnectionInfo &connection: index.getConnections()) {
+            if (!options.topics.empty() &&
+                std::find(options.topics.begin(), options.topics.end(), connection.topic) == options.topics.end())
+                continue;
+            ConnectionExport entry;
+            if (connection.msgType == "sensor_msgs/Image")
+                entry.kind = ExportKind::IMAGE;
+            else if ((entry.decoder = findScalarDecoder(connection.msgType)))
+                entry.kind = ExportKind::SCALAR;
+            else {
+                std::cerr << "Warning: no decoder for " << connection.topic << " (" << connection.msgType << ")"
+                          << std::endl;
+                continue;
+            }
+
+            auto it = std::find_if(topics.begin(), topics.end(), [&](const TopicOutput &topic) {
+                return topic.topic == connection.topic;
+            });
+            if (it != topics.end() && (it->kind != entry.kind || it->decoder != entry.decoder)) {
+                std::cerr << "Warning: " << connection.topic << " has connections of different types, exporting "
+                          << "the first one only" << std::endl;
+                continue;
+            }
+            if (it == topics.end()) {
+                // "/a/b" and "/a_b" map to the same file name, the later topic gets its connection id appended
+                std::string name = topicFileName(connection.topic);
+                auto taken = [&](const std::string &candidate) {
+                    return std::any_of(topics.begin(), topics.end(), [&](const TopicOutput &topic) {
+                        return topic.name == candidate;
+                    });
+                };
+                if (taken(name)) {
+                    std::string base = name + "_" + std::to_string(connection.id);
+                    name = base;
+                    for (int n = 2; taken(name); ++n)
+                        name = base + "_" + std::to_string(n);
+                    std::cerr << "Warning: " << connection.topic << " has the same file name as another topic, "
+                              << "exporting it as " << name << std::endl;
+                }
+                topics.emplace_back();
+                topics.back().topic = connection.topic;
+                topics.back().name = name;
+                topics.back().kind = entry.kind;
+                topics.back().decoder = entry.decoder;
+                it = topics.end() - 1;
+            }
+            entry.topic = static_cast<size_t>(it - topics.begin());
+            if (exports.size() <= connection.id)
+                exports.resize(connection.id + 1);
+            exports[connection.id] = entry;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(options.outputDir, ec);
+        for (const TopicOutput &topic: topics) {
+            if (topic.kind == ExportKind::IMAGE)
+                std::filesystem::create_directories(options.outputDir / topic.name, ec);
+        }
+        if (ec) {
+            std::cerr << "Error: could not create " << options.outputDir << ": " << ec.message() << std::endl;
+            return false;
+        }
+
+        // Chunks in file order; the per-topic message index at the start of every chunk follows from the counts
+        // in CHUNK_INFO, so image file names do not depend on which thread exports which chunk.
+        std::vector<ChunkInfo> chunks = index.getChunks();
+        std::sort(chunks.begin(), chunks.end(), [](const ChunkInfo &a, const ChunkInfo &b) {
+            return a.pos < b.pos;
+        });
+        std::vector<std::vector<uint64_t>> firstIndex(chunks.size(), std::vector<uint64_t>(topics.size()));
+        std::vector<uint64_t> counts(topics.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            firstIndex[i] = counts;
+            for (const auto &[conn, count]: chunks[i].messageCounts) {
+                if (conn < exports.size() && exports[conn].kind != ExportKind::NONE)
+                    counts[exports[conn].topic] += count;
+            }
+        }
+
+        const unsigned threads = static_cast<unsigned>(std::min<size_t>(std::max(1u, options.threads),
+                                                                          std::max<size_t>(chunks.size(), 1)));
+        // Finished chunks wait for all earlier ones before their rows are appended, so workers stay at most window
+        // chunks ahead of the oldest uncommitted one to bound the rows held in memory
+        const size_t window = 2 * threads;
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<ChunkOutput> outputs(chunks.size());
+        size_t committed = 0;
+        bool committing = false;
+
+        // Appends finished chunks to the scalar files in chunk order. Called with lock held; one thread commits at a
+        // time and does the file I/O without the lock so the other workers keep decoding.
+        auto commit = [&](std::unique_lock<std::mutex> &lock) {
+            if (committing)
+                return;
+            committing = true;
+            while (committed < outputs.size() && outputs[committed].ready) {
+                std::vector<ChunkOutput> batch;
+                for (; committed < outputs.size() && outputs[committed].ready; ++committed) {
+                    batch.push_back(std::move(outputs[committed]));
+                    outputs[committed] = ChunkOutput();
+                }
+                cv.notify_all();
+                lock.unlock();
+
+                uint64_t bytes = 0;
+                for (ChunkOutput &output: batch) {
+                    for (size_t t = 0; t < output.rows.size(); ++t) {
+                        if (output.rows[t].empty())
+                            continue;
+                        TopicOutput &topic = topics[t];
+                        if (!topic.file.is_open()) {
+                            std::filesystem::path path = options.outputDir / (topic.name + (options.binary ? ".bin" : ".csv"));
+                            topic.file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+                            if (options.binary) {
+                                std::ofstream(options.outputDir / (topic.name + ".columns")) << output.layout[t];
+                            } else {
+                                topic.file << "time";
+                                for (const std::string &column: topic.decoder->columns)
+                                    topic.file << "," << column;
+                                topic.file << "\n";
+                            }
+                        }
+                        topic.file.write(output.rows[t].data(), static_cast<std::streamsize>(output.rows[t].size()));
+                        bytes += output.rows[t].size();
+                    }
+                }
+
+                lock.lock();
+                result.bytesWritten += bytes;
+            }
+            committing = false;
+        };
+
+        auto worker = [&]() {
+            RosbagReader reader;
+            bool opened = reader.open(filePath);
+            ChunkRecord chunk;
+            std::vector<MessageRecord> messages;
+            std::vector<FieldValue> row;
+            ImageMessage image;
+            for (size_t i = next++; i < chunks.size(); i = next++) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return i < committed + window; });
+                }
+                ChunkOutput output;
+                output.rows.resize(topics.size());
+                output.layout.resize(topics.size());
+                ExportResult local;
+                std::vector<uint64_t> imageIndex = firstIndex[i];
+
+                bool read = opened && reader.readChunk(chunks[i].pos, chunk);
+                local.bytesRead = read ? chunk.data.size() : 0;
+                if (!read || !decompressChunk(chunk) || !parseMessages(chunk.data, messages)) {
+                    local.failedChunks.push_back(chunks[i].pos);
+                    messages.clear();
+                }
+
+                for (const MessageRecord &message: messages) {
+                    if (message.conn >= exports.size() || exports[message.conn].kind == ExportKind::NONE)
+                        continue;
+                    const ConnectionExport &entry = exports[message.conn];
+                    if (entry.kind == ExportKind::IMAGE) {
+                        std::ostringstream name;
+                        name << std::setw(6) << std::setfill('0') << imageIndex[entry.topic]++ << "_" << message.time;
+                        std::filesystem::path path = options.outputDir / topics[entry.topic].name / name.str();
+                        if (decodeImage(chunk.data, message.begin, message.end, image) &&
+                            writeImage(image, path, options.pngCompression, local.bytesWritten))
+                            local.images++;
+                        else
+                            local.skipped++;
+                    } else if (entry.decoder->decode(chunk.data, message.begin, message.end, row)) {
+                        std::string &rows = output.rows[entry.topic];
+                        if (options.binary) {
+                            if (rows.empty())
+                                output.layout[entry.topic] = binaryLayout(*entry.decoder, row);
+                            appendBinary(rows, message.time, row);
+                        } else {
+                            appendCsv(rows, message.time, row);
+                        }
+                        local.rows++;
+                    } else {
+                        local.skipped++;
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(mutex);
+                result.images += local.images;
+                result.rows += local.rows;
+                result.skipped += local.skipped;
+                result.bytesRead += local.bytesRead;
+                result.bytesWritten += local.bytesWritten;
+                result.failedChunks.insert(result.failedChunks.end(), local.failedChunks.begin(),
+                                           local.failedChunks.end());
+                output.ready = true;
+                outputs[i] = std::move(output);
+                commit(lock);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back(worker);
+        worker();
+        for (auto &thread: workers)
+            thread.join();
+
+        for (TopicOutput &topic: topics) {
+            if (topic.file.is_open())
+                topic.file.close();
+        }
+        std::sort(result.failedChunks.begin(), result.failedChunks.end());
+        return true;
+    }
+
+}
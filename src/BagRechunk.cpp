@@ -0,0 +1,261 @@
+//
+// Offline recompression and rechunking of ROS 1 bags.
+//
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <RosbagWriter/BagRechunk.h>
+#include <RosbagWriter/RosbagV2Backend.h>
+#include <RosbagReader/RosbagReader.h>
+
+namespace CRLRosWriter {
+
+    namespace {
+        // Input chunk after the decode stage
+        struct DecodedChunk {
+            bool ready = false;
+            bool ok = false;
+            CRLRosReader::ChunkRecord record;
+            std::vector<CRLRosReader::MessageRecord> messages;
+        };
+
+        // Output chunk between the sequencer and the writer
+        struct SealedChunk {
+            bool ready = false;
+            WriteChunk chunk;
+            StorageBackend::EncodedChunk encoded;
+        };
+    }
+
+    bool rechunkBag(const std::filesystem::path &input, const std::filesystem::path &output,
+                    const RechunkOptions &options, RechunkResult &result) {
+        result = RechunkResult();
+        CRLRosReader::RosbagReader index;
+        if (!index.open(input) || !index.readHeader())
+            return false;
+
+        RosbagV2Backend backend;
+        if (!isCompressionAvailable(options.compression) || !backend.supportsCompression(options.compression)) {
+            std::cerr << "Error: compression codec not available" << std::endl;
+            return false;
+        }
+        backend.setCompression(options.compression);
+
+        std::vector<CRLRosReader::ChunkInfo> source = index.getChunks();
+        std::sort(source.begin(), source.end(), [](const CRLRosReader::ChunkInfo &a, const CRLRosReader::ChunkInfo &b) {
+            return a.pos < b.pos;
+        });
+        result.inputChunks = static_cast<uint32_t>(source.size());
+
+        std::vector<Connection> connections;
+        std::map<uint32_t, size_t> connectionIndex;
+        for (const CRLRosReader::ConnectionInfo &info: index.getConnections()) {
+            connectionIndex[info.id] = connections.size();
+            connections.emplace_back(static_cast<int>(info.id), info.topic, info.msgType, info.md5sum, info.msgDef, -1);
+        }
+
+        // Opening the output truncates it, so it must not be the bag being read
+        std::error_code error;
+        if (std::filesystem::equivalent(input, output, error)) {
+            std::cerr << "Error: output " << output << " is the input bag" << std::endl;
+            return false;
+        }
+        // Write next to the output and rename on success, so a failed run leaves no partial bag behind
+        std::filesystem::path partial = output;
+        partial += ".tmp";
+        std::fstream bio(partial.string(), std::ios::out | std::ios::binary);
+        if (!bio) {
+            std::cerr << "Error: Could not open file " << partial << std::endl;
+            return false;
+        }
+        auto discard = [&]() {
+            bio.close();
+            std::filesystem::remove(partial, error);
+            return false;
+        };
+        backend.writeHeader(bio);
+
+        const unsigned threads = std::max(1u, options.threads);
+        const size_t window = 2 * threads;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool failed = false;
+
+        // Stage 1: read and decompress input chunks, at most window ahead of the sequencer
+        std::vector<DecodedChunk> decoded(source.size());
+        size_t consumed = 0;
+        std::atomic<size_t> nextDecode{0};
+        auto decoder = [&]() {
+            CRLRosReader::RosbagReader reader;
+            bool opened = reader.open(input);
+            for (size_t i = nextDecode++; i < source.size(); i = nextDecode++) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&] { return failed || i < consumed + window; });
+                    if (failed)
+                        return;
+                }
+                DecodedChunk chunk;
+                chunk.ok = opened && reader.readChunk(source[i].pos, chunk.record);
+                uint64_t stored = chunk.record.data.size();
+                chunk.ok = chunk.ok && CRLRosReader::decompressChunk(chunk.record) &&
+                           CRLRosReader::parseMessages(chunk.record.data, chunk.messages);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                result.bytesRead += stored;
+                chunk.ready = true;
+                decoded[i] = std::move(chunk);
+                cv.notify_all();
+            }
+        };
+
+        // Stage 3: compress sealed output chunks
+        std::map<size_t, SealedChunk> sealed;
+        std::deque<size_t> encodeQueue;
+        size_t sealedCount = 0;
+        bool sealingDone = false;
+        auto encoder = [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                cv.wait(lock, [&] { return failed || sealingDone || !encodeQueue.empty(); });
+                if (encodeQueue.empty())
+                    return;
+                SealedChunk &item = sealed[encodeQueue.front()]; // map nodes are stable while unlocked
+                encodeQueue.pop_front();
+                lock.unlock();
+                backend.encodeChunk(item.chunk, item.encoded);
+                lock.lock();
+                item.ready = true;
+                cv.notify_all();
+            }
+        };
+
+        // Stage 4: write chunks in order, keeping only the index information
+        std::vector<ChunkSummary> written;
+        auto writer = [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (size_t next = 0;; ++next) {
+                cv.wait(lock, [&] {
+                    return failed || (sealingDone && next == sealedCount) ||
+                           (sealed.count(next) && sealed[next].ready);
+                });
+                if (failed || next == sealedCount)
+                    return;
+                SealedChunk item = std::move(sealed[next]);
+                sealed.erase(next);
+                cv.notify_all();
+                lock.unlock();
+
+                backend.writeEncodedChunk(item.chunk, item.encoded, bio);
+                ChunkSummary summary = item.chunk.summary();
+                item = SealedChunk();
+                lock.lock();
+                written.push_back(std::move(summary));
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back(decoder);
+            workers.emplace_back(encoder);
+        }
+        workers.emplace_back(writer);
+
+        // Stage 2: regroup messages into new chunks in the original order
+        WriteChunk current;
+        std::vector<bool> connectionWritten(connections.size(), false);
+        auto seal = [&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return failed || sealed.size() < window; });
+            sealed[sealedCount].chunk = std::move(current);
+            encodeQueue.push_back(sealedCount++);
+            cv.notify_all();
+            current = WriteChunk();
+        };
+
+        const uint64_t limit = backend.maxChunkSize() - MESSAGE_RECORD_OVERHEAD;
+        const uint64_t threshold = std::min(options.chunkThreshold, limit);
+        std::vector<uint8_t> data;
+        for (size_t i = 0; i < source.size() && !failed; ++i) {
+            DecodedChunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return decoded[i].ready; });
+                chunk = std::move(decoded[i]);
+                consumed = i + 1;
+                if (!chunk.ok) {
+                    std::cerr << "Error: could not read chunk at " << source[i].pos << " of " << input << std::endl;
+                    failed = true;
+                }
+                cv.notify_all();
+            }
+
+            for (const CRLRosReader::MessageRecord &message: chunk.messages) {
+                if (failed)
+                    break;
+                auto it = connectionIndex.find(message.conn);
+                if (it == connectionIndex.end())
+                    continue;
+                Connection &connection = connections[it->second];
+                // Input messages come from v2 chunks, so each one fits, but not necessarily next to the others
+                if (current.data.tellp() > 0 &&
+                    static_cast<uint64_t>(current.data.tellp()) > limit - (message.end - message.begin))
+                    seal();
+                if (!connectionWritten[it->second]) {
+                    backend.writeConnection(connection, current.data);
+                    connectionWritten[it->second] = true;
+                }
+
+                current.connections[connection.id].emplace_back(message.time,
+                                                                static_cast<uint64_t>(current.data.tellp()));
+                current.start = std::min(current.start, message.time);
+                current.end = std::max(current.end, message.time);
+                data.assign(chunk.record.data.begin() + static_cast<std::ptrdiff_t>(message.begin),
+                            chunk.record.data.begin() + static_cast<std::ptrdiff_t>(message.end));
+                backend.writeMessage(connection, message.time, data, current.data);
+                result.messages++;
+
+                if (static_cast<uint64_t>(current.data.tellp()) > threshold)
+                    seal();
+            }
+        }
+        if (!failed && current.data.tellp() > 0)
+            seal();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sealingDone = true;
+            cv.notify_all();
+        }
+        for (auto &thread: workers)
+            thread.join();
+        if (failed)
+            return discard();
+
+        backend.writeIndex(connections, written, bio);
+        bio.flush();
+        result.outputChunks = static_cast<uint32_t>(written.size());
+        bio.seekp(0, std::ios::end);
+        result.bytesWritten = static_cast<uint64_t>(bio.tellp());
+        bio.close();
+        if (!bio) {
+            std::cerr << "Error: could not write " << partial << std::endl;
+            return discard();
+        }
+        std::filesystem::rename(partial, output, error);
+        if (error) {
+            std::cerr << "Error: could not rename " << partial << " to " << output << ": " << error.message()
+                      << std::endl;
+            return discard();
+        }
+        return true;
+    }
+
+}
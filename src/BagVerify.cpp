@@ -0,0 +1,63 @@
+//
+// Parallel chunk checksum verification.
+//
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <RosbagWriter/Crc32c.h>
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/BagVerify.h"
+
+namespace CRLRosReader {
+
+    bool verifyBag(const std::filesystem::path &filePath, unsigned threads, VerifyResult &result) {
+        result = VerifyResult();
+        RosbagReader index;
+        if (!index.open(filePath) || !index.readHeader())
+            return false;
+
+        // Read chunks in file order so every thread moves forward through the file
+        std::vector<uint64_t> positions;
+        for (const ChunkInfo &chunk: index.getChunks())
+            positions.push_back(chunk.pos);
+        std::sort(positions.begin(), positions.end());
+        result.chunks = static_cast<uint32_t>(positions.size());
+
+        std::atomic<size_t> next{0};
+        std::mutex mutex;
+        auto worker = [&]() {
+            RosbagReader reader;
+            bool opened = reader.open(filePath);
+            ChunkRecord chunk;
+            for (size_t i = next++; i < positions.size(); i = next++) {
+                bool read = opened && reader.readChunk(positions[i], chunk);
+                bool valid = read && (!chunk.hasCrc ||
+                                      CRLRosWriter::crc32c(chunk.data.data(), chunk.data.size()) == chunk.crc);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!valid) {
+                    result.corrupt.push_back(positions[i]);
+                    continue;
+                }
+                result.bytes += chunk.data.size();
+                if (chunk.hasCrc)
+                    result.verified++;
+                else
+                    result.unchecked++;
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < std::min<size_t>(std::max(1u, threads), positions.size()); ++t)
+            workers.emplace_back(worker);
+        worker();
+        for (auto &thread: workers)
+            thread.join();
+
+        std::sort(result.corrupt.begin(), result.corrupt.end());
+        return true;
+    }
+
+}
@@ -0,0 +1,175 @@
+//
+// Chunk compression codecs shared by the storage backends.
+//
+#include <iostream>
+#include <string>
+
+#ifdef ROSBAG_WRITER_WITH_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef ROSBAG_WRITER_WITH_ZSTD
+#include <zstd.h>
+#endif
+#ifdef ROSBAG_WRITER_WITH_BZ2
+#include <bzlib.h>
+#endif
+
+#include <RosbagWriter/Compression.h>
+
+namespace CRLRosWriter {
+
+    bool isCompressionAvailable(CompressionType type) {
+        switch (type) {
+            case CompressionType::NONE:
+                return true;
+            case CompressionType::LZ4:
+#ifdef ROSBAG_WRITER_WITH_LZ4
+                return true;
+#else
+                return false;
+#endif
+            case CompressionType::ZSTD:
+#ifdef ROSBAG_WRITER_WITH_ZSTD
+                return true;
+#else
+                return false;
+#endif
+            case CompressionType::BZ2:
+#ifdef ROSBAG_WRITER_WITH_BZ2
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    bool compress(CompressionType type, const std::string &src, std::string &dst) {
+        switch (type) {
+            case CompressionType::NONE:
+                dst = src;
+                return true;
+            case CompressionType::LZ4: {
+#ifdef ROSBAG_WRITER_WITH_LZ4
+                // Independent blocks with a content checksum, which is what the roslz4 stream reader expects.
+                LZ4F_preferences_t prefs = LZ4F_INIT_PREFERENCES;
+                prefs.frameInfo.blockSizeID = LZ4F_max4MB;
+                prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+                prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+                dst.resize(LZ4F_compressFrameBound(src.size(), &prefs));
+                size_t size = LZ4F_compressFrame(dst.data(), dst.size(), src.data(), src.size(), &prefs);
+                if (LZ4F_isError(size)) {
+                    std::cerr << "LZ4 compression failed: " << LZ4F_getErrorName(size) << std::endl;
+                    return false;
+                }
+                dst.resize(size);
+                return true;
+#else
+                break;
+#endif
+            }
+            case CompressionType::ZSTD: {
+#ifdef ROSBAG_WRITER_WITH_ZSTD
+                dst.resize(ZSTD_compressBound(src.size()));
+                size_t size = ZSTD_compress(dst.data(), dst.size(), src.data(), src.size(), 1);
+                if (ZSTD_isError(size)) {
+                    std::cerr << "ZSTD compression failed: " << ZSTD_getErrorName(size) << std::endl;
+                    return false;
+                }
+                dst.resize(size);
+                return true;
+#else
+                break;
+#endif
+            }
+            case CompressionType::BZ2: {
+#ifdef ROSBAG_WRITER_WITH_BZ2
+                // Worst case output given in the bzip2 manual: 1% + 600 bytes
+                auto size = static_cast<unsigned int>(src.size() + src.size() / 100 + 600);
+                dst.resize(size);
+                int ret = BZ2_bzBuffToBuffCompress(dst.data(), &size, const_cast<char *>(src.data()),
+                                                   static_cast<unsigned int>(src.size()), 9, 0, 30);
+                if (ret != BZ_OK) {
+                    std::cerr << "BZ2 compression failed: " << ret << std::endl;
+                    return false;
+                }
+                dst.resize(size);
+                return true;
+#else
+                break;
+#endif
+            }
+        }
+        return false;
+    }
+
+    bool decompress(CompressionType type, const std::string &src, std::string &dst, size_t uncompressedSize) {
+        switch (type) {
+            case CompressionType::NONE:
+                dst = src;
+                return true;
+            case CompressionType::LZ4: {
+#ifdef ROSBAG_WRITER_WITH_LZ4
+                LZ4F_dctx *ctx = nullptr;
+                if (LZ4F_isError(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION)))
+                    return false;
+                dst.resize(uncompressedSize);
+                size_t srcPos = 0, dstPos = 0, hint = 1;
+                while (hint != 0 && srcPos < src.size()) {
+                    size_t srcSize = src.size() - srcPos;
+                    size_t dstSize = dst.size() - dstPos;
+                    hint = LZ4F_decompress(ctx, dst.data() + dstPos, &dstSize, src.data() + srcPos, &srcSize, nullptr);
+                    if (LZ4F_isError(hint)) {
+                        std::cerr << "LZ4 decompression failed: " << LZ4F_getErrorName(hint) << std::endl;
+                        LZ4F_freeDecompressionContext(ctx);
+                        return false;
+                    }
+                    srcPos += srcSize;
+                    dstPos += dstSize;
+                    // A frame holding more than uncompressedSize stalls once dst is full
+                    if (hint != 0 && srcSize == 0 && dstSize == 0) {
+                        std::cerr << "LZ4 decompression failed: frame larger than " << uncompressedSize << " bytes"
+                                  << std::endl;
+                        LZ4F_freeDecompressionContext(ctx);
+                        return false;
+                    }
+                }
+                LZ4F_freeDecompressionContext(ctx);
+                // hint != 0 means the frame was truncated
+                return hint == 0 && dstPos == uncompressedSize;
+#else
+                break;
+#endif
+            }
+            case CompressionType::ZSTD: {
+#ifdef ROSBAG_WRITER_WITH_ZSTD
+                dst.resize(uncompressedSize);
+                size_t size = ZSTD_decompress(dst.data(), dst.size(), src.data(), src.size());
+                if (ZSTD_isError(size)) {
+                    std::cerr << "ZSTD decompression failed: " << ZSTD_getErrorName(size) << std::endl;
+                    return false;
+                }
+                return size == uncompressedSize;
+#else
+                break;
+#endif
+            }
+            case CompressionType::BZ2: {
+#ifdef ROSBAG_WRITER_WITH_BZ2
+                auto size = static_cast<unsigned int>(uncompressedSize);
+                dst.resize(uncompressedSize);
+                int ret = BZ2_bzBuffToBuffDecompress(dst.data(), &size, const_cast<char *>(src.data()),
+                                                     static_cast<unsigned int>(src.size()), 0, 0);
+                if (ret != BZ_OK) {
+                    std::cerr << "BZ2 decompression failed: " << ret << std::endl;
+                    return false;
+                }
+                return size == uncompressedSize;
+#else
+                break;
+#endif
+            }
+        }
+        return false;
+    }
+}
@@ -0,0 +1,106 @@
+//
+// CRC-32C used for chunk integrity checks.
+//
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define ROSBAG_WRITER_CRC32C_SSE42
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define ROSBAG_WRITER_CRC32C_ARM
+#endif
+
+#include <RosbagWriter/Crc32c.h>
+
+namespace CRLRosWriter {
+
+    static std::array<std::array<uint32_t, 256>, 8> makeTables() {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; ++k)
+                crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+            tables[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t t = 1; t < 8; ++t)
+                tables[t][i] = (tables[t - 1][i] >> 8) ^ tables[0][tables[t - 1][i] & 0xFF];
+        }
+        return tables;
+    }
+
+    static const std::array<std::array<uint32_t, 256>, 8> crcTables = makeTables();
+
+    uint32_t crc32c_sw(const void *data, size_t size, uint32_t crc) {
+        auto p = static_cast<const uint8_t *>(data);
+        uint32_t c = ~crc;
+        while (size >= 8) {
+            uint32_t lo, hi;
+            std::memcpy(&lo, p, 4);
+            std::memcpy(&hi, p + 4, 4);
+            lo ^= c; // little endian hosts only, like the rest of the serializers
+            c = crcTables[7][lo & 0xFF] ^ crcTables[6][(lo >> 8) & 0xFF] ^ crcTables[5][(lo >> 16) & 0xFF] ^
+                crcTables[4][lo >> 24] ^ crcTables[3][hi & 0xFF] ^ crcTables[2][(hi >> 8) & 0xFF] ^
+                crcTables[1][(hi >> 16) & 0xFF] ^ crcTables[0][hi >> 24];
+            p += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+            c = (c >> 8) ^ crcTables[0][(c ^ *p++) & 0xFF];
+        return ~c;
+    }
+
+#if defined(ROSBAG_WRITER_CRC32C_SSE42)
+    __attribute__((target("sse4.2")))
+    static uint32_t crc32c_hw(const void *data, size_t size, uint32_t crc) {
+        auto p = static_cast<const uint8_t *>(data);
+        uint64_t c = ~crc;
+        while (size >= 8) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            c = _mm_crc32_u64(c, v);
+            p += 8;
+            size -= 8;
+        }
+        auto c32 = static_cast<uint32_t>(c);
+        while (size-- > 0)
+            c32 = _mm_crc32_u8(c32, *p++);
+        return ~c32;
+    }
+
+    static bool hasHardwareCrc() {
+        static const bool supported = __builtin_cpu_supports("sse4.2");
+        return supported;
+    }
+#elif defined(ROSBAG_WRITER_CRC32C_ARM)
+    static uint32_t crc32c_hw(const void *data, size_t size, uint32_t crc) {
+        auto p = static_cast<const uint8_t *>(data);
+        uint32_t c = ~crc;
+        while (size >= 8) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            c = __crc32cd(c, v);
+            p += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+            c = __crc32cb(c, *p++);
+        return ~c;
+    }
+
+    static bool hasHardwareCrc() {
+        return true;
+    }
+#endif
+
+    uint32_t crc32c(const void *data, size_t size, uint32_t crc) {
+#if defined(ROSBAG_WRITER_CRC32C_SSE42) || defined(ROSBAG_WRITER_CRC32C_ARM)
+        if (hasHardwareCrc())
+            return crc32c_hw(data, size, crc);
+#endif
+        return crc32c_sw(data, size, crc);
+    }
+
+}
@@ -0,0 +1,226 @@
+//
+// MCAP encoding for RosbagWriter (https://mcap.dev/spec).
+//
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <RosbagWriter/McapBackend.h>
+
+namespace CRLRosWriter {
+
+    static const char *compressionName(CompressionType type) {
+        switch (type) {
+            case CompressionType::LZ4:
+                return "lz4";
+            case CompressionType::ZSTD:
+                return "zstd";
+            default:
+                return "";
+        }
+    }
+
+    bool McapBackend::supportsCompression(CompressionType type) const {
+        return type != CompressionType::BZ2;
+    }
+
+    void McapBackend::writeHeader(std::ostream &bio) {
+        bio.write(MCAP_MAGIC, sizeof(MCAP_MAGIC));
+        McapRecord header;
+        header.put_string("ros1");
+        header.put_string("rosbag_writer_cpp");
+        header.write(bio, McapOpcode::HEADER);
+    }
+
+    uint16_t McapBackend::schemaId(const Connection &connection) {
+        auto it = schemaIds.find(connection.msgType);
+        if (it != schemaIds.end())
+            return it->second;
+        // Schema id 0 is reserved for channels without a schema
+        auto id = static_cast<uint16_t>(schemaIds.size() + 1);
+        schemaIds[connection.msgType] = id;
+        return id;
+    }
+
+    void McapBackend::writeSchema(const Connection &connection, std::ostream &dst) {
+        McapRecord schema;
+        schema.put_uint16(schemaId(connection));
+        schema.put_string(connection.msgType);
+        schema.put_string("ros1msg");
+        schema.put_string(connection.msgDef);
+        schema.write(dst, McapOpcode::SCHEMA);
+    }
+
+    void McapBackend::writeChannel(const Connection &connection, std::ostream &dst) {
+        McapRecord channel;
+        channel.put_uint16(static_cast<uint16_t>(connection.id));
+        channel.put_uint16(schemaId(connection));
+        channel.put_string(connection.topic);
+        channel.put_string("ros1");
+        channel.put_map(std::map<std::string, std::string>{{"md5sum", connection.md5sum}});
+        channel.write(dst, McapOpcode::CHANNEL);
+    }
+
+    void McapBackend::writeConnection(const Connection &connection, std::ostream &dst) {
+        writeSchema(connection, dst);
+        writeChannel(connection, dst);
+    }
+
+    void McapBackend::writeMessage(const Connection &connection, int64_t timestamp, const std::vector<uint8_t> &data,
+                                   std::ostream &dst) {
+        McapRecord message;
+        message.put_uint16(static_cast<uint16_t>(connection.id));
+        message.put_uint32(sequences[connection.id]++);
+        message.put_uint64(static_cast<uint64_t>(timestamp));
+        message.put_uint64(static_cast<uint64_t>(timestamp));
+        message.write(dst, McapOpcode::MESSAGE, reinterpret_cast<const char *>(data.data()), data.size());
+    }
+
+    void McapBackend::encodeChunk(const WriteChunk &chunk, EncodedChunk &encoded) const {
+        std::string data = chunk.data.str();
+        encoded.size = data.size();
+        encoded.type = compression;
+        if (encoded.type != CompressionType::NONE && !CRLRosWriter::compress(encoded.type, data, encoded.payload))
+            encoded.type = CompressionType::NONE;
+        if (encoded.type == CompressionType::NONE)
+            encoded.payload = std::move(data);
+    }
+
+    void McapBackend::writeEncodedChunk(WriteChunk &chunk, const EncodedChunk &encoded, std::ostream &bio) {
+        chunk.pos = static_cast<int64_t>(bio.tellp());
+        const std::string &payload = encoded.payload;
+
+        ChunkIndex index{};
+        bool empty = chunk.start == std::numeric_limits<int64_t>::max();
+        index.start = empty ? 0 : static_cast<uint64_t>(chunk.start);
+        index.end = empty ? 0 : static_cast<uint64_t>(chunk.end);
+        index.chunkStart = static_cast<uint64_t>(chunk.pos);
+        index.compression = compressionName(encoded.type);
+        index.compressedSize = payload.size();
+        index.uncompressedSize = encoded.size;
+
+        McapRecord record;
+        record.put_uint64(index.start);
+        record.put_uint64(index.end);
+        record.put_uint64(index.uncompressedSize);
+        record.put_uint32(0); // uncompressed_crc, 0 = not computed
+        record.put_string(index.compression);
+        record.put_uint64(index.compressedSize);
+        index.chunkLength = record.write(bio, McapOpcode::CHUNK, payload.data(), payload.size());
+
+        // Message indexes follow the chunk, sorted by log time as required by the spec
+        uint64_t indexStart = static_cast<uint64_t>(bio.tellp());
+        for (const auto &[cid, items]: chunk.connections) {
+            std::vector<std::pair<int64_t, uint64_t>> sorted = items;
+            std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+                return a.first < b.first;
+            });
+
+            index.messageIndexOffsets[static_cast<uint16_t>(cid)] = static_cast<uint64_t>(bio.tellp());
+            McapRecord messageIndex;
+            messageIndex.put_uint16(static_cast<uint16_t>(cid));
+            messageIndex.put_uint32(static_cast<uint32_t>(sorted.size() * 16));
+            for (const auto &[time, offset]: sorted) {
+                messageIndex.put_uint64(static_cast<uint64_t>(time));
+                messageIndex.put_uint64(offset);
+            }
+            messageIndex.write(bio, McapOpcode::MESSAGE_INDEX);
+        }
+        index.messageIndexLength = static_cast<uint64_t>(bio.tellp()) - indexStart;
+        chunkIndexes.push_back(std::move(index));
+    }
+
+    void McapBackend::writeIndex(const std::vector<Connection> &connections, const std::vector<ChunkSummary> &chunks,
+                                 std::ostream &bio) {
+        McapRecord dataEnd;
+        dataEnd.put_uint32(0); // data_section_crc, 0 = not computed
+        dataEnd.write(bio, McapOpcode::DATA_END);
+
+        auto summaryStart = static_cast<uint64_t>(bio.tellp());
+        std::vector<std::pair<McapOpcode, std::pair<uint64_t, uint64_t>>> groups;
+        auto beginGroup = [&]() { return static_cast<uint64_t>(bio.tellp()); };
+        auto endGroup = [&](McapOpcode opcode, uint64_t start) {
+            groups.emplace_back(opcode, std::make_pair(start, static_cast<uint64_t>(bio.tellp()) - start));
+        };
+
+        uint64_t start = beginGroup();
+        std::map<uint16_t, bool> written;
+        for (const Connection &connection: connections) {
+            uint16_t id = schemaId(connection);
+            if (written[id]) continue;
+            written[id] = true;
+            writeSchema(connection, bio);
+        }
+        endGroup(McapOpcode::SCHEMA, start);
+
+        start = beginGroup();
+        for (const Connection &connection: connections)
+            writeChannel(connection, bio);
+        endGroup(McapOpcode::CHANNEL, start);
+
+        uint64_t messageCount = 0;
+        uint64_t messageStart = std::numeric_limits<uint64_t>::max();
+        uint64_t messageEnd = 0;
+        uint32_t chunkCount = 0;
+        std::map<uint16_t, uint64_t> channelCounts;
+        for (const ChunkSummary &chunk: chunks) {
+            ++chunkCount;
+            for (const auto &[cid, count]: chunk.counts) {
+                channelCounts[static_cast<uint16_t>(cid)] += count;
+                messageCount += count;
+            }
+            if (chunk.start != std::numeric_limits<int64_t>::max()) {
+                messageStart = std::min(messageStart, static_cast<uint64_t>(chunk.start));
+                messageEnd = std::max(messageEnd, static_cast<uint64_t>(chunk.end));
+            }
+        }
+
+        start = beginGroup();
+        McapRecord statistics;
+        statistics.put_uint64(messageCount);
+        statistics.put_uint16(static_cast<uint16_t>(schemaIds.size()));
+        statistics.put_uint32(static_cast<uint32_t>(connections.size()));
+        statistics.put_uint32(0); // attachment_count
+        statistics.put_uint32(0); // metadata_count
+        statistics.put_uint32(chunkCount);
+        statistics.put_uint64(messageCount == 0 ? 0 : messageStart);
+        statistics.put_uint64(messageEnd);
+        statistics.put_map(channelCounts);
+        statistics.write(bio, McapOpcode::STATISTICS);
+        endGroup(McapOpcode::STATISTICS, start);
+
+        start = beginGroup();
+        for (const ChunkIndex &index: chunkIndexes) {
+            McapRecord record;
+            record.put_uint64(index.start);
+            record.put_uint64(index.end);
+            record.put_uint64(index.chunkStart);
+            record.put_uint64(index.chunkLength);
+            record.put_map(index.messageIndexOffsets);
+            record.put_uint64(index.messageIndexLength);
+            record.put_string(index.compression);
+            record.put_uint64(index.compressedSize);
+            record.put_uint64(index.uncompressedSize);
+            record.write(bio, McapOpcode::CHUNK_INDEX);
+        }
+        endGroup(McapOpcode::CHUNK_INDEX, start);
+
+        auto summaryOffsetStart = static_cast<uint64_t>(bio.tellp());
+        for (const auto &[opcode, range]: groups) {
+            McapRecord summaryOffset;
+            summaryOffset.put_uint8(static_cast<uint8_t>(opcode));
+            summaryOffset.put_uint64(range.first);
+            summaryOffset.put_uint64(range.second);
+            summaryOffset.write(bio, McapOpcode::SUMMARY_OFFSET);
+        }
+
+        McapRecord footer;
+        footer.put_uint64(summaryStart);
+        footer.put_uint64(summaryOffsetStart);
+        footer.put_uint32(0); // summary_crc, 0 = not computed
+        footer.write(bio, McapOpcode::FOOTER);
+        bio.write(MCAP_MAGIC, sizeof(MCAP_MAGIC));
+    }
+
+}
@@ -0,0 +1,106 @@
+//
+// Decoders for the message types RosbagWriter knows how to write.
+//
+#include <cstring>
+#include <unordered_map>
+
+#include "RosbagReader/Header.h"
+#include "RosbagReader/MessageDecoders.h"
+
+namespace CRLRosReader {
+
+    static bool readUint32(const std::vector<uint8_t> &bytes, size_t &index, size_t end, uint32_t &value) {
+        if (end - index < 4)
+            return false;
+        value = deserialize_uint32(bytes, index);
+        return true;
+    }
+
+    static bool readString(const std::vector<uint8_t> &bytes, size_t &index, size_t end, std::string &value) {
+        uint32_t length = 0;
+        if (!readUint32(bytes, index, end, length) || end - index < length)
+            return false;
+        value.assign(reinterpret_cast<const char *>(bytes.data() + index), length);
+        index += length;
+        return true;
+    }
+
+    static bool readFloat64(const std::vector<uint8_t> &bytes, size_t &index, size_t end, double &value) {
+        if (end - index < 8)
+            return false;
+        uint64_t raw = deserialize_uint64(bytes, index);
+        std::memcpy(&value, &raw, sizeof(value));
+        return true;
+    }
+
+    bool decodeHeader(const std::vector<uint8_t> &bytes, size_t &index, size_t end, RosHeader &header) {
+        if (end > bytes.size() || end - index < 12)
+            return false;
+        header.seq = deserialize_uint32(bytes, index);
+        header.stamp = deserialize_time(bytes, index);
+        return readString(bytes, index, end, header.frameId);
+    }
+
+    bool decodeImage(const std::vector<uint8_t> &bytes, size_t begin, size_t end, ImageMessage &image) {
+        size_t index = begin;
+        if (!decodeHeader(bytes, index, end, image.header) ||
+            !readUint32(bytes, index, end, image.height) ||
+            !readUint32(bytes, index, end, image.width) ||
+            !readString(bytes, index, end, image.encoding) || index == end)
+            return false;
+        image.isBigEndian = deserialize_uint8(bytes, index);
+        if (!readUint32(bytes, index, end, image.step) || !readUint32(bytes, index, end, image.dataSize) ||
+            end - index < image.dataSize)
+            return false;
+        image.data = bytes.data() + index;
+        return static_cast<uint64_t>(image.step) * image.height <= image.dataSize;
+    }
+
+    static std::unordered_map<std::string, ScalarDecoder> &registry() {
+        static std::unordered_map<std::string, ScalarDecoder> decoders = {
+                {"std_msgs/Header", {{"seq", "stamp", "frame_id"},
+                                     [](const std::vector<uint8_t> &bytes, size_t begin, size_t end,
+                                        std::vector<FieldValue> &row) {
+                                         RosHeader header;
+                                         if (!decodeHeader(bytes, begin, end, header))
+                                             return false;
+                                         row = {static_cast<int64_t>(header.seq), header.stamp, header.frameId};
+                                         return true;
+                                     }}},
+                {"std_msgs/String", {{"data"},
+                                     [](const std::vector<uint8_t> &bytes, size_t begin, size_t end,
+                                        std::vector<FieldValue> &row) {
+                                         std::string data;
+                                         if (!readString(bytes, begin, end, data))
+                                             return false;
+                                         row = {std::move(data)};
+                                         return true;
+                                     }}},
+                {"sensor_msgs/Temperature", {{"seq", "stamp", "temperature", "variance"},
+                                             [](const std::vector<uint8_t> &bytes, size_t begin, size_t end,
+                                                std::vector<FieldValue> &row) {
+                                                 RosHeader header;
+                                                 double temperature = 0, variance = 0;
+                                                 if (!decodeHeader(bytes, begin, end, header) ||
+                                                     !readFloat64(bytes, begin, end, temperature) ||
+                                                     !readFloat64(bytes, begin, end, variance))
+                                                     return false;
+                                                 row = {static_cast<int64_t>(header.seq), header.stamp,
+                                                        temperature, variance};
+                                                 return true;
+                                             }}},
+        };
+        return decoders;
+    }
+
+    void registerScalarDecoder(const std::string &msgType, ScalarDecoder decoder) {
+        registry()[msgType] = std::move(decoder);
+    }
+
+    const ScalarDecoder *findScalarDecoder(const std::string &msgType) {
+        auto &decoders = registry();
+        auto it = decoders.find(msgType);
+        return it == decoders.end() ? nullptr : &it->second;
+    }
+
+}
@@ -0,0 +1,202 @@
+//
+// Real-time paced playback with lookahead I/O.
+//
+#include <algorithm>
+#include <cmath>
+
+#include "RosbagReader/Player.h"
+
+namespace CRLRosReader {
+
+    using Clock = std::chrono::steady_clock;
+
+    // Messages smaller than 1/SPARSE_COPY_RATIO of their chunk are copied out of it before they are queued
+    static constexpr size_t SPARSE_COPY_RATIO = 16;
+
+    int64_t PlaybackStats::percentile(double fraction) const {
+        if (delivered == 0 || histogram.empty())
+            return 0;
+        auto target = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(delivered)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < histogram.size(); ++i) {
+            seen += histogram[i];
+            if (seen >= std::max<uint64_t>(target, 1))
+                return std::min(static_cast<int64_t>(i + 1) * BUCKET_NS, maxLateness);
+        }
+        return maxLateness;
+    }
+
+    Player::~Player() {
+        joinIo();
+    }
+
+    void Player::joinIo() {
+        stop();
+        if (io.joinable())
+            io.join();
+    }
+
+    bool Player::open(const std::filesystem::path &bag) {
+        return open(std::vector<std::filesystem::path>{bag});
+    }
+
+    bool Player::open(const std::vector<std::filesystem::path> &bags) {
+        return dataset.open(bags);
+    }
+
+    bool Player::openDirectory(const std::filesystem::path &directory) {
+        return dataset.openDirectory(directory);
+    }
+
+    void Player::stop() {
+        stopping = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+        }
+        cv.notify_all();
+    }
+
+    PlaybackStats Player::getStats() const {
+        // delivered is read before the histogram, so the histogram holds at least that many deliveries
+        PlaybackStats stats;
+        stats.delivered = delivered.load();
+        stats.underruns = underruns.load();
+        stats.peakQueued = peakQueued.load();
+        stats.maxLateness = maxLateness.load();
+        stats.meanLateness = meanLateness.load();
+        stats.histogram.resize(PlaybackStats::BUCKETS);
+        for (size_t i = 0; i < PlaybackStats::BUCKETS; ++i)
+            stats.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // Playback thread only
+    void Player::record(int64_t lateness) {
+        histogram[std::min(static_cast<size_t>(lateness / PlaybackStats::BUCKET_NS), PlaybackStats::BUCKETS - 1)]
+                .fetch_add(1, std::memory_order_relaxed);
+        uint64_t count = delivered.load(std::memory_order_relaxed) + 1;
+        double mean = meanLateness.load(std::memory_order_relaxed);
+        meanLateness.store(mean + (static_cast<double>(lateness) - mean) / static_cast<double>(count));
+        maxLateness.store(std::max(maxLateness.load(std::memory_order_relaxed), lateness));
+        delivered.store(count);
+    }
+
+    void Player::prefetch() {
+        BagDataset::Cursor cursor = dataset.messages(options.start, options.end, options.topics);
+        DatasetMessage message;
+        while (!stopping && cursor.next(message)) {
+            // A small message would keep its whole chunk alive in the queue, e.g. IMU samples in chunks of images
+            if (message.size() * SPARSE_COPY_RATIO < message.chunk->size()) {
+                message.chunk = std::make_shared<const std::vector<uint8_t>>(message.data(),
+                                                                             message.data() + message.size());
+                message.begin = 0;
+                message.end = message.chunk->size();
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return stopping || queuedBytes < options.prefetchBytes; });
+            if (stopping)
+                break;
+            if (queuedBuffers[message.chunk.get()]++ == 0)
+                queuedBytes += message.chunk->size();
+            queuedBytes += sizeof(DatasetMessage);
+            peakQueued.store(std::max(peakQueued.load(std::memory_order_relaxed), queuedBytes));
+            queue.push_back(std::move(message));
+            cv.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ioDone = true;
+        ioFailed = cursor.failed();
+        cv.notify_all();
+    }
+
+    // Called with mutex held
+    void Player::dequeue(DatasetMessage &message) {
+        message = std::move(queue.front());
+        queue.pop_front();
+        queuedBytes -= sizeof(DatasetMessage);
+        auto it = queuedBuffers.find(message.chunk.get());
+        if (--it->second == 0) {
+            queuedBytes -= message.chunk->size();
+            queuedBuffers.erase(it);
+        }
+    }
+
+    bool Player::play(const Callback &callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.clear();
+            queuedBuffers.clear();
+            queuedBytes = 0;
+            ioDone = false;
+            ioFailed = false;
+        }
+        delivered = 0;
+        underruns = 0;
+        peakQueued = 0;
+        maxLateness = 0;
+        meanLateness = 0;
+        for (size_t i = 0; i < PlaybackStats::BUCKETS; ++i)
+            histogram[i].store(0, std::memory_order_relaxed);
+        stopping = false;
+        io = std::thread(&Player::prefetch, this);
+        // Also on an exception from the callback, a joinable io would terminate the next play()
+        struct JoinOnExit {
+            Player *player;
+            ~JoinOnExit() { player->joinIo(); }
+        } joinOnExit{this};
+
+        // Preroll: start the clock once the I/O thread is well ahead
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&] { return stopping || ioDone || queuedBytes >= options.prefetchBytes / 2; });
+        }
+
+        bool started = false;
+        Clock::time_point wallStart;
+        int64_t bagStart = 0;
+        DatasetMessage message;
+        while (!stopping) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (queue.empty() && !ioDone) {
+                    underruns.store(underruns.load(std::memory_order_relaxed) + 1);
+                    cv.wait(lock, [&] { return stopping || ioDone || !queue.empty(); });
+                }
+                if (stopping || queue.empty())
+                    break;
+                dequeue(message);
+            }
+            cv.notify_all();
+
+            if (!started) {
+                started = true;
+                wallStart = Clock::now();
+                bagStart = message.time;
+            }
+            int64_t lateness = 0;
+            if (options.rate > 0) {
+                auto offset = std::chrono::nanoseconds(
+                        static_cast<int64_t>(static_cast<double>(message.time - bagStart) / options.rate));
+                Clock::time_point target = wallStart + offset;
+                // Sleep until shortly before the deadline, waking up early on stop(), then spin for precision
+                if (target - Clock::now() > options.spin) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (cv.wait_until(lock, target - options.spin, [&] { return stopping.load(); }))
+                        break;
+                }
+                Clock::time_point now = Clock::now();
+                while (now < target)
+                    now = Clock::now();
+                lateness = std::chrono::duration_cast<std::chrono::nanoseconds>(now - target).count();
+            }
+            record(lateness);
+            callback(message);
+        }
+
+        joinIo();
+        std::lock_guard<std::mutex> lock(mutex);
+        return !ioFailed;
+    }
+
+}
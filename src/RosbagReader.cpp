@@ -2,4 +2,268 @@
 // Created by mgjer on 28/11/2023.
 //
 
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include <RosbagWriter/Header.h>
+#include <RosbagWriter/Compression.h>
 #include "RosbagReader/RosbagReader.h"
+
+namespace CRLRosReader {
+
+    using CRLRosWriter::RecordType;
+
+    // Parses the record at buf[pos]: <uint32 header_len><header><uint32 data_len><data>. Advances pos past the record.
+    static bool parseRecord(const std::vector<uint8_t> &buf, size_t &pos, Header &header, size_t &dataBegin,
+                            size_t &dataEnd) {
+        if (pos + 4 > buf.size())
+            return false;
+        uint32_t headerLen = deserialize_uint32(buf, pos);
+        if (headerLen > buf.size() - pos || !header.parse(buf, pos, pos + headerLen))
+            return false;
+        pos += headerLen;
+        if (pos + 4 > buf.size())
+            return false;
+        uint32_t dataLen = deserialize_uint32(buf, pos);
+        if (dataLen > buf.size() - pos)
+            return false;
+        dataBegin = pos;
+        dataEnd = pos + dataLen;
+        pos = dataEnd;
+        return true;
+    }
+
+    bool RosbagReader::open(const std::filesystem::path &filePath) {
+        path = filePath;
+        bio = std::ifstream(path, std::ios::in | std::ios::binary);
+        if (!bio) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            return false;
+        }
+        std::error_code ec;
+        fileSize = std::filesystem::file_size(path, ec);
+        return true;
+    }
+
+    bool RosbagReader::readHeader() {
+        if (!bio.is_open())
+            return false;
+
+        // Version line + BAGHEADER record padded to 4096 bytes
+        std::vector<uint8_t> buf(13 + 4096);
+        bio.seekg(0);
+        bio.read(reinterpret_cast<char *>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        buf.resize(static_cast<size_t>(bio.gcount()));
+        if (buf.size() < 13 || std::memcmp(buf.data(), "#ROSBAG V2.0\n", 13) != 0) {
+            std::cerr << "Error: " << path << " is not a rosbag v2.0 file" << std::endl;
+            return false;
+        }
+
+        size_t pos = 13, dataBegin = 0, dataEnd = 0;
+        Header header;
+        if (!parseRecord(buf, pos, header, dataBegin, dataEnd) ||
+            header.get_uint8("op") != static_cast<uint8_t>(RecordType::BAGHEADER)) {
+            std::cerr << "Error: " << path << " has a corrupt bag header" << std::endl;
+            return false;
+        }
+        indexPos = header.get_uint64("index_pos");
+        connCount = header.get_uint32("conn_count");
+        chunkCount = header.get_uint32("chunk_count");
+        if (indexPos == 0) {
+            std::cerr << "Error: " << path << " is not indexed (writer was not closed)" << std::endl;
+            return false;
+        }
+        return readIndex();
+    }
+
+    bool RosbagReader::readIndex() {
+        bio.clear();
+        bio.seekg(0, std::ios::end);
+        fileSize = static_cast<uint64_t>(bio.tellg());
+        // A bag without messages has no index records, its index_pos is the end of the file
+        if (indexPos > fileSize) {
+            std::cerr << "Error: " << path << " index_pos is past the end of the file" << std::endl;
+            return false;
+        }
+
+        std::vector<uint8_t> buf(fileSize - indexPos);
+        bio.seekg(static_cast<std::streamoff>(indexPos));
+        bio.read(reinterpret_cast<char *>(buf.data()), static_cast<std::streamsize>(buf.size()));
+        if (static_cast<size_t>(bio.gcount()) != buf.size())
+            return false;
+
+        connections.clear();
+        chunks.clear();
+        size_t pos = 0;
+        while (pos < buf.size()) {
+            Header header;
+            size_t dataBegin = 0, dataEnd = 0;
+            if (!parseRecord(buf, pos, header, dataBegin, dataEnd)) {
+                std::cerr << "Error: " << path << " has a truncated index section" << std::endl;
+                return false;
+            }
+
+            auto op = static_cast<RecordType>(header.get_uint8("op"));
+            if (op == RecordType::CONNECTION) {
+                Header connHeader;
+                connHeader.parse(buf, dataBegin, dataEnd);
+                ConnectionInfo info;
+                info.id = header.get_uint32("conn");
+                info.topic = header.get_string("topic");
+                info.msgType = connHeader.get_string("type");
+                info.md5sum = connHeader.get_string("md5sum");
+                info.msgDef = connHeader.get_string("message_definition");
+                connections.push_back(std::move(info));
+            } else if (op == RecordType::CHUNK_INFO) {
+                ChunkInfo info;
+                info.pos = header.get_uint64("chunk_pos");
+                info.start = header.get_time("start_time");
+                info.end = header.get_time("end_time");
+                uint32_t count = header.get_uint32("count");
+                size_t index = dataBegin;
+                for (uint32_t i = 0; i < count && index + 8 <= dataEnd; ++i) {
+                    uint32_t conn = deserialize_uint32(buf, index);
+                    info.messageCounts[conn] = deserialize_uint32(buf, index);
+                }
+                chunks.push_back(std::move(info));
+            }
+        }
+
+        if (connections.size() != connCount || chunks.size() != chunkCount) {
+            std::cerr << "Warning: " << path << " index has " << connections.size() << "/" << connCount
+                      << " connections and " << chunks.size() << "/" << chunkCount << " chunks" << std::endl;
+        }
+        return true;
+    }
+
+    bool RosbagReader::readChunk(uint64_t pos, ChunkRecord &chunk) {
+        // Lengths come from the file and may be corrupt, check them against the file size before allocating
+        if (pos > fileSize || fileSize - pos < 8) {
+            std::cerr << "Error: chunk position " << pos << " is past the end of " << path << std::endl;
+            return false;
+        }
+        uint64_t available = fileSize - pos - 8;
+        std::vector<uint8_t> buf(4);
+        size_t index = 0;
+        bio.clear();
+        bio.seekg(static_cast<std::streamoff>(pos));
+        if (!bio.read(reinterpret_cast<char *>(buf.data()), 4))
+            return false;
+        uint32_t headerLen = deserialize_uint32(buf, index);
+        if (headerLen > (1 << 20) || headerLen > available) {
+            std::cerr << "Error: " << path << " has an invalid chunk header length at " << pos << std::endl;
+            return false;
+        }
+        buf.resize(headerLen + 4);
+        if (!bio.read(reinterpret_cast<char *>(buf.data()), static_cast<std::streamsize>(buf.size())))
+            return false;
+
+        Header header;
+        if (!header.parse(buf, 0, headerLen) ||
+            header.get_uint8("op") != static_cast<uint8_t>(RecordType::CHUNK)) {
+            std::cerr << "Error: " << path << " has no chunk record at " << pos << std::endl;
+            return false;
+        }
+        index = headerLen;
+        uint32_t dataLen = deserialize_uint32(buf, index);
+        if (dataLen > available - headerLen) {
+            std::cerr << "Error: " << path << " has an invalid chunk data length at " << pos << std::endl;
+            return false;
+        }
+
+        chunk.pos = pos;
+        chunk.compression = header.get_string("compression");
+        chunk.size = header.get_uint32("size");
+        chunk.hasCrc = header.has("crc32c");
+        chunk.crc = header.get_uint32("crc32c");
+        chunk.data.resize(dataLen);
+        return static_cast<bool>(bio.read(reinterpret_cast<char *>(chunk.data.data()), dataLen));
+    }
+
+    BagSummary RosbagReader::summary() const {
+        BagSummary summary;
+        summary.path = path;
+        std::error_code ec;
+        summary.fileSize = std::filesystem::file_size(path, ec);
+        summary.chunkCount = static_cast<uint32_t>(chunks.size());
+
+        std::unordered_map<uint32_t, uint64_t> perConnection;
+        bool first = true;
+        for (const ChunkInfo &chunk: chunks) {
+            uint64_t messages = 0;
+            for (const auto &[conn, count]: chunk.messageCounts) {
+                perConnection[conn] += count;
+                messages += count;
+            }
+            if (messages == 0)
+                continue;
+            summary.messageCount += messages;
+            summary.start = first ? chunk.start : std::min(summary.start, chunk.start);
+            summary.end = first ? chunk.end : std::max(summary.end, chunk.end);
+            first = false;
+        }
+
+        for (const ConnectionInfo &connection: connections) {
+            auto it = std::find_if(summary.topics.begin(), summary.topics.end(), [&](const TopicInfo &topic) {
+                return topic.topic == connection.topic && topic.msgType == connection.msgType;
+            });
+            if (it == summary.topics.end()) {
+                summary.topics.push_back({connection.topic, connection.msgType, 0, 0});
+                it = summary.topics.end() - 1;
+            }
+            it->messageCount += perConnection[connection.id];
+            it->connections++;
+        }
+        std::sort(summary.topics.begin(), summary.topics.end(), [](const TopicInfo &a, const TopicInfo &b) {
+            return a.topic < b.topic;
+        });
+        return summary;
+    }
+
+    bool decompressChunk(ChunkRecord &chunk) {
+        CRLRosWriter::CompressionType type;
+        if (chunk.compression.empty() || chunk.compression == "none")
+            return true;
+        else if (chunk.compression == "lz4")
+            type = CRLRosWriter::CompressionType::LZ4;
+        else if (chunk.compression == "bz2")
+            type = CRLRosWriter::CompressionType::BZ2;
+        else {
+            std::cerr << "Error: unsupported chunk compression '" << chunk.compression << "'" << std::endl;
+            return false;
+        }
+
+        std::string src(chunk.data.begin(), chunk.data.end());
+        std::string dst;
+        if (!CRLRosWriter::decompress(type, src, dst, chunk.size) || dst.size() != chunk.size)
+            return false;
+        chunk.data.assign(dst.begin(), dst.end());
+        chunk.compression = "none";
+        return true;
+    }
+
+    bool parseMessages(const std::vector<uint8_t> &data, std::vector<MessageRecord> &messages) {
+        messages.clear();
+        size_t pos = 0;
+        while (pos < data.size()) {
+            Header header;
+            size_t dataBegin = 0, dataEnd = 0;
+            if (!parseRecord(data, pos, header, dataBegin, dataEnd))
+                return false;
+            if (header.get_uint8("op") != static_cast<uint8_t>(RecordType::MSGDATA))
+                continue;
+            messages.push_back({header.get_uint32("conn"), header.get_time("time"), dataBegin, dataEnd});
+        }
+        return true;
+    }
+
+    bool readSummary(const std::filesystem::path &filePath, BagSummary &summary) {
+        RosbagReader reader;
+        if (!reader.open(filePath) || !reader.readHeader())
+            return false;
+        summary = reader.summary();
+        return true;
+    }
+
+}
@@ -0,0 +1,142 @@
+//
+// ROS 1 bag v2.0 encoding, split out of RosbagWriter.cpp.
+//
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <RosbagWriter/RosbagV2Backend.h>
+#include <RosbagWriter/Crc32c.h>
+
+namespace CRLRosWriter {
+
+    static const char *compressionName(CompressionType type) {
+        switch (type) {
+            case CompressionType::LZ4:
+                return "lz4";
+            case CompressionType::BZ2:
+                return "bz2";
+            default:
+                return "none";
+        }
+    }
+
+    bool RosbagV2Backend::supportsCompression(CompressionType type) const {
+        return type == CompressionType::NONE || type == CompressionType::LZ4 || type == CompressionType::BZ2;
+    }
+
+    void RosbagV2Backend::writeHeader(std::ostream &bio) {
+        bio.write("#ROSBAG V2.0\n", 13);
+        writeBagHeader(bio, 0, 1, 1);
+    }
+
+    void RosbagV2Backend::writeBagHeader(std::ostream &bio, uint64_t indexPos, uint32_t connCount, uint32_t chunkCount) {
+        Header header;
+        header.set_uint64("index_pos", indexPos);
+        header.set_uint32("conn_count", connCount);
+        header.set_uint32("chunk_count", chunkCount);
+        int size = header.write(bio, RecordType::BAGHEADER);
+        int padsize = 4096 - 4 - size;
+        bio.write(reinterpret_cast<const char *>(serialize_uint32(padsize).data()), 4);
+        bio.write(std::string(padsize, ' ').c_str(), padsize);
+    }
+
+    void RosbagV2Backend::writeConnection(const Connection &connection, std::ostream &bagIO) {
+        Header header;
+        header.set_uint32("conn", connection.id);
+        header.set_string("topic", connection.topic);
+        header.write(bagIO, RecordType::CONNECTION);
+
+        Header msgHeader;
+        msgHeader.set_string("topic", connection.topic);
+        msgHeader.set_string("type", connection.msgType);
+        msgHeader.set_string("md5sum", connection.md5sum);
+        msgHeader.set_string("message_definition", connection.msgDef);
+        msgHeader.write(bagIO);
+    }
+
+    void RosbagV2Backend::writeMessage(const Connection &connection, int64_t timestamp, const std::vector<uint8_t> &data,
+                                       std::ostream &dst) {
+        Header header;
+        header.set_uint32("conn", connection.id);
+        header.set_time("time", timestamp);
+
+        header.write(dst, RecordType::MSGDATA);
+        dst.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(data.size())).data()), 4);
+        dst.write(reinterpret_cast<const char *>(data.data()), static_cast<uint32_t>(data.size()));
+    }
+
+    void RosbagV2Backend::encodeChunk(const WriteChunk &chunk, EncodedChunk &encoded) const {
+        std::string data = chunk.data.str();
+        encoded.size = data.size();
+        encoded.type = compression;
+        if (encoded.type != CompressionType::NONE && (!CRLRosWriter::compress(encoded.type, data, encoded.payload) ||
+                                                      encoded.payload.size() > maxChunkSize()))
+            encoded.type = CompressionType::NONE;
+        if (encoded.type == CompressionType::NONE)
+            encoded.payload = std::move(data);
+    }
+
+    void RosbagV2Backend::writeEncodedChunk(WriteChunk &chunk, const EncodedChunk &encoded, std::ostream &bio) {
+        chunk.pos = static_cast<int64_t>(bio.tellp());
+        const std::string &payload = encoded.payload;
+
+        Header header;
+        header.set_string("compression", compressionName(encoded.type));
+        header.set_uint32("size", static_cast<uint32_t>(encoded.size));
+        // Not part of the 2.0 format; readers skip unknown header fields. Covers the payload as stored on disk.
+        header.set_uint32("crc32c", crc32c(payload.data(), payload.size()));
+        header.write(bio, RecordType::CHUNK);
+
+        bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(payload.size())).data()), 4);
+        bio.write(payload.c_str(), static_cast<uint32_t>(payload.size()));
+
+        for (const auto &[cid, items]: chunk.connections) {
+            Header idxHeader;
+            idxHeader.set_uint32("ver", 1);
+            idxHeader.set_uint32("conn", cid);
+            idxHeader.set_uint32("count", static_cast<uint32_t>(items.size()));
+            idxHeader.write(bio, RecordType::IDXDATA);
+            bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(items.size() * 12)).data()), 4);
+
+            for (const auto &[time, offset]: items) {
+                bio.write(reinterpret_cast<const char *>(serialize_time(time).data()), 8);
+                // Offsets are relative to the chunk, the uint32 chunk size field bounds them
+                bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(offset)).data()), 4);
+
+            }
+        }
+    }
+
+    void RosbagV2Backend::writeIndex(const std::vector<Connection> &connections, const std::vector<ChunkSummary> &chunks,
+                                     std::ostream &bio) {
+        auto index_pos = static_cast<uint64_t>(bio.tellp());
+
+        for (const Connection &connection: connections) {
+            writeConnection(connection, bio);
+        }
+
+        for (const ChunkSummary &chunk: chunks) {
+            Header header;
+            header.set_uint32("ver", 1);
+            header.set_uint64("chunk_pos", static_cast<uint64_t>(chunk.pos));
+            header.set_time("start_time", chunk.start == std::numeric_limits<int64_t>::max() ? 0 : chunk.start);
+            header.set_time("end_time", chunk.end);
+            header.set_uint32("count", static_cast<uint32_t>(chunk.counts.size()));
+            header.write(bio, RecordType::CHUNK_INFO);
+
+            int size = static_cast<int>(chunk.counts.size() * 8);
+            bio.write(reinterpret_cast<const char *>(serialize_uint32(size).data()), 4);
+
+            for (const auto &[cid, count]: chunk.counts) {
+                bio.write(reinterpret_cast<const char *>(serialize_uint32(cid).data()), 4);
+                bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(count)).data()), 4);
+            }
+        }
+
+        bio.seekp(13);
+        writeBagHeader(bio, index_pos, static_cast<uint32_t>(connections.size()), static_cast<uint32_t>(chunks.size()));
+    }
+
+}
@@ -14,8 +14,18 @@
 #include <cerrno>
 #include <cstring>
 #include <algorithm>
+#include <map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ROSBAG_WRITER_HAS_FSYNC
+#endif
 
 #include <RosbagWriter/RosbagWriter.h>
+#include <RosbagWriter/RosbagV2Backend.h>
+#include <RosbagWriter/McapBackend.h>
 
 namespace CRLRosWriter {
 
@@ -30,87 +40,317 @@ namespace CRLRosWriter {
             exit(1);
         }
 
-        writeHeader();
+        backend->writeHeader(bio);
         opened = true;
+
+        if (preallocation > 0) {
+#ifdef __linux__
+            fd = ::open(path.c_str(), O_WRONLY);
+#endif
+            preallocate(static_cast<uint64_t>(bio.tellp()));
+        }
+
+        if (durable) {
+#ifdef ROSBAG_WRITER_HAS_FSYNC
+            sync_fd = ::open(path.c_str(), O_WRONLY);
+            if (sync_fd < 0)
+                std::cerr << "Warning: could not open " << path << " for syncing: " << std::strerror(errno) << std::endl;
+#endif
+            committer = std::thread(&RosbagWriter::commit_loop, this);
+        }
     }
 
-    void RosbagWriter::writeHeader() {
-        bio.write("#ROSBAG V2.0\n", 13);
-        Header header;
-        header.set_uint64("index_pos", 0);
-        header.set_uint32("conn_count", 1);
-        header.set_uint32("chunk_count", 1);
-        int size = header.write(bio, RecordType::BAGHEADER);
-        int padsize = 4096 - 4 - size;
-        bio.write(reinterpret_cast<const char *>(serialize_uint32(padsize).data()), 4);
-        bio.write(std::string(padsize, ' ').c_str(), padsize);
+    bool RosbagWriter::setChunkThreshold(uint64_t bytes) {
+        uint64_t limit = backend->maxChunkSize() - MESSAGE_RECORD_OVERHEAD;
+        chunk_threshold = std::min(bytes, limit);
+        if (bytes > limit) {
+            std::cerr << "Chunk threshold " << bytes << " exceeds the storage format limit, using " << limit
+                      << std::endl;
+            return false;
+        }
+        return true;
     }
 
-    void RosbagWriter::write(Connection &connection, int64_t timestamp, std::vector<uint8_t> data) {
-        WriteChunk &chunk = chunks.back();
-        chunk.connections[connection.id].emplace_back(timestamp, static_cast<int>(chunk.data.tellp()));
+    void RosbagWriter::setDurability(std::chrono::microseconds maxDelay) {
+#ifdef ROSBAG_WRITER_HAS_FSYNC
+        durable = true;
+        commit_delay = maxDelay;
+#else
+        (void) maxDelay;
+        std::cerr << "Error: durable writes are not supported on this platform" << std::endl;
+#endif
+    }
 
-        chunk.start = std::min(chunk.start, timestamp);
-        chunk.end = std::max(chunk.end, timestamp);
+    void RosbagWriter::preallocate(uint64_t end) {
+#ifdef __linux__
+        if (fd < 0 || end + chunk_threshold <= allocated)
+            return;
+        // Reserve beyond EOF without changing the file size, readers of an unfinished bag see only written data
+        uint64_t target = std::max(allocated + preallocation, end + chunk_threshold);
+        if (fallocate(fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(allocated), static_cast<off_t>(target - allocated)) != 0) {
+            std::cerr << "Warning: preallocation disabled for " << path << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            fd = -1;
+            return;
+        }
+        allocated = target;
+#else
+        (void) end;
+#endif
+    }
+
+    void RosbagWriter::releasePreallocation() {
+#ifdef __linux__
+        if (fd < 0)
+            return;
+        // Truncating to the current size frees the extents reserved past EOF
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && ftruncate(fd, st.st_size) != 0)
+            std::cerr << "Warning: could not trim " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        fd = -1;
+#endif
+    }
 
-        Header header;
-        header.set_uint32("conn", connection.id);
-        header.set_time("time", timestamp);
+    void RosbagWriter::write(Connection &connection, int64_t timestamp, std::vector<uint8_t> data) {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t index;
+        append(lock, connection, timestamp, data, index);
+    }
 
-        header.write(chunk.data, RecordType::MSGDATA);
-        chunk.data.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(data.size())).data()), 4);
-        chunk.data.write(reinterpret_cast<const char *>(data.data()), static_cast<uint32_t>(data.size()));
+    std::future<bool> RosbagWriter::writeDurable(Connection &connection, int64_t timestamp, std::vector<uint8_t> data) {
+        auto promise = std::make_shared<std::promise<bool>>();
+        std::future<bool> future = promise->get_future();
+        writeDurable(connection, timestamp, std::move(data), [promise](bool ok) { promise->set_value(ok); });
+        return future;
+    }
 
-        if (chunk.data.tellp() > chunk_threshold) {
-            write_chunk(chunk);
+    void RosbagWriter::writeDurable(Connection &connection, int64_t timestamp, std::vector<uint8_t> data,
+                                    std::function<void(bool)> onDurable) {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t index;
+        if (!append(lock, connection, timestamp, data, index)) {
+            lock.unlock();
+            onDurable(false);
+            return;
         }
+        if (!committer.joinable()) {
+            lock.unlock();
+            std::cerr << "Error: writeDurable requires setDurability() before open()" << std::endl;
+            onDurable(false);
+            return;
+        }
+        if (pending.empty())
+            first_pending = std::chrono::steady_clock::now();
+        pending.push_back({index, std::move(onDurable)});
+        lock.unlock();
+        commit_cv.notify_one();
     }
 
-// Continuing within the RosbagWriter class from the previous conversions...
+    void RosbagWriter::commit_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            commit_cv.wait(lock, [this] { return stop_commit || !pending.empty(); });
+            if (pending.empty())
+                break;
+            // Give other durable writes until the deadline of the oldest one to join this commit
+            commit_cv.wait_until(lock, first_pending + commit_delay, [this] { return stop_commit; });
+
+            // Writes queued while the lock is released below belong to the next commit
+            std::vector<DurableWrite> batch;
+            batch.swap(pending);
+
+            // Pending writes are in chunk order, only the newest can still be in the open chunk. A chunk sealed
+            // by a writer may still be compressing, wait until it is in the file too.
+            sealed_cv.wait(lock, [this] { return !sealing; });
+            if (batch.back().chunk == sealed_chunks)
+                write_chunk(lock);
+            bio.flush();
+            bool ok = static_cast<bool>(bio);
+
+            // Sync without holding the lock so writers can fill the next chunk meanwhile
+            lock.unlock();
+            ok = sync() && ok;
+            for (DurableWrite &write: batch)
+                write.done(ok);
+            lock.lock();
+        }
+    }
 
+    bool RosbagWriter::sync() {
+        ++sync_count;
+#if defined(__linux__)
+        bool synced = sync_fd >= 0 && fdatasync(sync_fd) == 0;
+#elif defined(__APPLE__)
+        // fsync only reaches the drive cache on macOS; F_FULLFSYNC is not supported by every file system
+        bool synced = sync_fd >= 0 && (fcntl(sync_fd, F_FULLFSYNC) == 0 || fsync(sync_fd) == 0);
+#elif defined(ROSBAG_WRITER_HAS_FSYNC)
+        bool synced = sync_fd >= 0 && fsync(sync_fd) == 0;
+#else
+        bool synced = false;
+        errno = ENOSYS;
+#endif
+        if (!synced) {
+            std::cerr << "Error: could not sync " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        return true;
+    }
 
-    void RosbagWriter::write_chunk(WriteChunk &chunk) {
-        if (!bio.is_open()) {
-            std::cerr << "File not open!" << std::endl;
-            return;
+    bool RosbagWriter::append(std::unique_lock<std::mutex> &lock, Connection &connection, int64_t timestamp,
+                              const std::vector<uint8_t> &data, size_t &chunk_index) {
+        // A message crossing the threshold can still overflow the format limit, seal the chunk before it instead
+        const uint64_t limit = backend->maxChunkSize() - MESSAGE_RECORD_OVERHEAD;
+        if (data.size() > limit) {
+            std::cerr << "Error: message of " << data.size() << " bytes on " << connection.topic
+                      << " exceeds the chunk size limit, dropped" << std::endl;
+            return false;
         }
+        if (static_cast<uint64_t>(chunk.data.tellp()) > limit - data.size())
+            write_chunk(lock);
 
-        int size = static_cast<int>(chunk.data.tellp());
-        if (size > 0) {
-            chunk.pos = static_cast<int>(bio.tellp());
+        chunk_index = sealed_chunks;
+        chunk.connections[connection.id].emplace_back(timestamp, static_cast<uint64_t>(chunk.data.tellp()));
 
-            Header header;
-            header.set_string("compression", "none");
-            header.set_uint32("size", size);
-            header.write(bio, RecordType::CHUNK);
+        chunk.start = std::min(chunk.start, timestamp);
+        chunk.end = std::max(chunk.end, timestamp);
 
-            std::string data = chunk.data.str();
+        backend->writeMessage(connection, timestamp, data, chunk.data);
+
+        auto size = static_cast<uint64_t>(chunk.data.tellp());
+        usage.index += sizeof(std::pair<int64_t, uint64_t>);
+        usage.chunkBuffer = chunk_cost(size) + in_flight;
+        usage.peak = std::max(usage.peak, usage.total());
+        if (size > chunk_threshold) {
+            write_chunk(lock);
+        } else if (memory_budget > 0 && usage.chunkBuffer > memory_budget - std::min(usage.index, memory_budget)) {
+            // Only the chunk buffer can be given back; the index of a long recording may outgrow a small budget, so
+            // chunks are never sealed below the minimum size instead of degrading to one message per chunk
+            if (!usage.unattainable && usage.index + chunk_cost(min_chunk_size()) > memory_budget) {
+                usage.unattainable = true;
+                std::cerr << "Warning: memory budget of " << memory_budget << " bytes for " << path
+                          << " cannot hold the index (" << usage.index << " bytes) and a chunk of "
+                          << min_chunk_size() << " bytes, chunks are not sealed below that size" << std::endl;
+            }
+            if (size >= min_chunk_size()) {
+                usage.earlySeals++;
+                write_chunk(lock);
+            }
+        }
+        return true;
+    }
 
-            bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(data.size())).data()), 4);
-            bio.write(data.c_str(), static_cast<uint32_t>(data.size()));
+    uint64_t RosbagWriter::chunk_cost(uint64_t size) const {
+        // An estimate, the capacity of the stream is not observable: its buffer grows geometrically to up to twice
+        // the content, encoding copies the content out and compression adds an output buffer of about that size
+        return size * (backend->getCompression() == CompressionType::NONE ? 3 : 4);
+    }
 
-            for (const auto &[cid, items]: chunk.connections) {
-                Header idxHeader;
-                idxHeader.set_uint32("ver", 1);
-                idxHeader.set_uint32("conn", cid);
-                idxHeader.set_uint32("count", static_cast<uint32_t>(items.size()));
-                idxHeader.write(bio, RecordType::IDXDATA);
-                bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(items.size() * 12)).data()), 4);
+    uint64_t RosbagWriter::min_chunk_size() const {
+        return std::min<uint64_t>(64 * 1024, chunk_threshold);
+    }
 
-                for (const auto &[time, offset]: items) {
-                    bio.write(reinterpret_cast<const char *>(serialize_time(time).data()), 8);
-                    bio.write(reinterpret_cast<const char *>(serialize_uint32(offset).data()), 4);
+    MemoryUsage RosbagWriter::getMemoryUsage() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        MemoryUsage result = usage;
+        result.budget = memory_budget;
+        return result;
+    }
 
-                }
+    void RosbagWriter::release_chunk(const WriteChunk &sealed) {
+        written.push_back(sealed.summary());
+        usage.index += sizeof(ChunkSummary) + written.back().counts.size() * sizeof(std::pair<int, uint64_t>);
+        for (const auto &[cid, items]: sealed.connections) {
+            usage.index -= items.size() * sizeof(std::pair<int64_t, uint64_t>);
+            if (!time_index)
+                continue;
+            std::vector<TimeIndexEntry> &entries = time_entries[cid];
+            for (const auto &[time, offset]: items)
+                entries.push_back({time, static_cast<uint64_t>(sealed.pos), offset});
+            usage.index += items.size() * sizeof(TimeIndexEntry);
+        }
+        if (time_index && memory_budget > 0 && usage.index > memory_budget / 2)
+            spill_index();
+    }
+
+    void RosbagWriter::spill_index() {
+        // Spilling is tried once per chunk; after a failure the time index stays in memory for the whole recording
+        if (spill_failed)
+            return;
+        std::string spillPath = path.string() + ".tidx.spill";
+        if (!spill.is_open()) {
+            spill.open(spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!spill) {
+                spill_failed = true;
+                std::cerr << "Warning: Could not open " << spillPath << ", keeping the time index in memory"
+                          << std::endl;
+                return;
+            }
+        }
+
+        spill.seekp(0, std::ios::end);
+        for (auto &[cid, entries]: time_entries) {
+            if (entries.empty())
+                continue;
+            auto offset = static_cast<uint64_t>(spill.tellp());
+            spill.write(reinterpret_cast<const char *>(entries.data()),
+                        static_cast<std::streamsize>(entries.size() * sizeof(TimeIndexEntry)));
+            if (!spill) {
+                // Runs written so far stay valid, the entries that did not make it remain in memory
+                spill_failed = true;
+                spill.clear();
+                std::cerr << "Warning: Could not write " << spillPath << ", keeping the rest of the time index in "
+                          << "memory" << std::endl;
+                return;
             }
+            spilled_runs[cid].push_back({offset, entries.size()});
+            usage.index -= entries.size() * sizeof(TimeIndexEntry);
+            usage.index += sizeof(SpilledRun);
+            usage.spilledEntries += entries.size();
+            std::vector<TimeIndexEntry>().swap(entries);
+        }
+    }
 
-            chunk.data.clear();
-            chunks.emplace_back();
+    void RosbagWriter::write_chunk(std::unique_lock<std::mutex> &lock) {
+        if (!bio.is_open()) {
+            std::cerr << "File not open!" << std::endl;
+            return;
         }
+
+        // One chunk is encoded at a time so chunks reach the file in order
+        sealed_cv.wait(lock, [this] { return !sealing; });
+        if (chunk.data.tellp() <= 0)
+            return;
+
+        // Moving the chunk out frees the open chunk's buffer; writers append to a new one while this one is
+        // compressed without the lock
+        WriteChunk sealed = std::move(chunk);
+        chunk = WriteChunk();
+        ++sealed_chunks;
+        sealing = true;
+        in_flight = usage.chunkBuffer;
+        lock.unlock();
+
+        StorageBackend::EncodedChunk encoded;
+        backend->encodeChunk(sealed, encoded);
+
+        lock.lock();
+        backend->writeEncodedChunk(sealed, encoded, bio);
+        release_chunk(sealed);
+        sealing = false;
+        usage.chunkBuffer -= in_flight;
+        in_flight = 0;
+        sealed_cv.notify_all();
+        preallocate(static_cast<uint64_t>(bio.tellp()));
     }
 
 
     Connection RosbagWriter::add_connection(const std::string &topic, const std::string &msg_type) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return register_connection(topic, msg_type);
+    }
+
+    Connection RosbagWriter::register_connection(const std::string &topic, const std::string &msg_type) {
 
         std::string msg_def, md5sum;
 
@@ -126,85 +366,131 @@ namespace CRLRosWriter {
 
         //std::cout << "md5: " << md5sum << " for " << msg_type << std::endl;
         Connection connection(static_cast<int>(connections.size()), topic, msg_type, md5sum, msg_def, -1);
-//
-        auto &chunkBio = chunks.back().data;
-        write_connection(connection, chunkBio);
+        auto &chunkBio = chunk.data;
+        backend->writeConnection(connection, chunkBio);
+        usage.chunkBuffer = chunk_cost(static_cast<uint64_t>(chunkBio.tellp())) + in_flight;
         connections.push_back(connection);
         return connection;
     }
 
-    void RosbagWriter::write_connection(const Connection &connection, std::ostream &bagIO) {
-        Header header;
-        header.set_uint32("conn", connection.id);
-        header.set_string("topic", connection.topic);
-        header.write(bagIO, RecordType::CONNECTION);
-
-        Header msgHeader;
-        msgHeader.set_string("topic", connection.topic);
-        msgHeader.set_string("type", connection.msgType);
-        msgHeader.set_string("md5sum", connection.md5sum);
-        msgHeader.set_string("message_definition", connection.msgDef);
-        msgHeader.write(bagIO);
-    }
-
     void RosbagWriter::close() {
         //std::cout << "Closing" << std::endl;
-        if (!bio.is_open()) return;
-
-        for (WriteChunk &chunk: chunks) {
-            if (chunk.pos == -1) {
-                write_chunk(chunk);
+        if (committer.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop_commit = true;
             }
+            commit_cv.notify_one();
+            committer.join();
         }
+        if (!bio.is_open()) return;
 
-        int index_pos = static_cast<int>(bio.tellp());
-
-        for (const Connection &connection: connections) {
-            write_connection(connection, bio);
+        std::unique_lock<std::mutex> lock(mutex);
+        write_chunk(lock);
+        backend->writeIndex(connections, written, bio);
+        bio.flush();
+        releasePreallocation();
+#ifdef ROSBAG_WRITER_HAS_FSYNC
+        if (sync_fd >= 0) {
+            sync();
+            ::close(sync_fd);
+            sync_fd = -1;
         }
+#endif
+        if (time_index)
+            write_time_index();
+        if (spill.is_open()) {
+            spill.close();
+            std::error_code ec;
+            std::filesystem::remove(path.string() + ".tidx.spill", ec);
+        }
+        opened = false;
+    }
 
-        for (const WriteChunk &chunk: chunks) {
-            if (chunk.pos == -1) continue;
-
-            Header header;
-            header.set_uint32("ver", 1);
-            header.set_uint64("chunk_pos", chunk.pos);
-            header.set_time("start_time", chunk.start == INT_MAX ? 0 : chunk.start);
-            header.set_time("end_time", chunk.end);
-            header.set_uint32("count", static_cast<uint32_t>(chunk.connections.size()));
-            header.write(bio, RecordType::CHUNK_INFO);
+    void RosbagWriter::write_time_index() {
+        // Entries are gathered one connection at a time, from the spill file and from memory
+        std::map<int, uint64_t> counts;
+        for (const auto &[cid, runs]: spilled_runs) {
+            for (const SpilledRun &run: runs)
+                counts[cid] += run.count;
+        }
+        for (const auto &[cid, entries]: time_entries) {
+            if (!entries.empty())
+                counts[cid] += entries.size();
+        }
 
-            int size = static_cast<int>(chunk.connections.size() * 8);
-            bio.write(reinterpret_cast<const char *>(serialize_uint32(size).data()), 4);
+        TimeIndexFileHeader header{};
+        std::memcpy(header.magic, TIME_INDEX_MAGIC, sizeof(header.magic));
+        header.connCount = static_cast<uint32_t>(counts.size());
+        std::error_code ec;
+        header.bagSize = std::filesystem::file_size(path, ec);
+
+        std::vector<TimeIndexDirectoryEntry> directory;
+        uint64_t offset = sizeof(header) + counts.size() * sizeof(TimeIndexDirectoryEntry);
+        for (const auto &[cid, count]: counts) {
+            directory.push_back({static_cast<uint32_t>(cid), 0, offset, count});
+            offset += count * sizeof(TimeIndexEntry);
+        }
 
-            for (const auto &[cid, items]: chunk.connections) {
-                bio.write(reinterpret_cast<const char *>(serialize_uint32(cid).data()), 4);
-                bio.write(reinterpret_cast<const char *>(serialize_uint32(static_cast<uint32_t>(items.size())).data()), 4);
+        const std::string indexPath = path.string() + ".tidx";
+        std::ofstream out(indexPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Could not open file " << indexPath << std::endl;
+            return;
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(directory.data()),
+                  static_cast<std::streamsize>(directory.size() * sizeof(TimeIndexDirectoryEntry)));
+
+        if (spill.is_open())
+            spill.flush();
+        std::vector<TimeIndexEntry> list;
+        for (const auto &[cid, count]: counts) {
+            list.clear();
+            list.reserve(count);
+            for (const SpilledRun &run: spilled_runs[cid]) {
+                list.resize(list.size() + run.count);
+                spill.seekg(static_cast<std::streamoff>(run.offset));
+                spill.read(reinterpret_cast<char *>(list.data() + list.size() - run.count),
+                           static_cast<std::streamsize>(run.count * sizeof(TimeIndexEntry)));
             }
+            const std::vector<TimeIndexEntry> &entries = time_entries[cid];
+            list.insert(list.end(), entries.begin(), entries.end());
+            std::stable_sort(list.begin(), list.end(), [](const TimeIndexEntry &a, const TimeIndexEntry &b) {
+                return a.time < b.time;
+            });
+            out.write(reinterpret_cast<const char *>(list.data()),
+                      static_cast<std::streamsize>(list.size() * sizeof(TimeIndexEntry)));
         }
 
-        bio.seekp(13);
-        Header indexHeader;
-        indexHeader.set_uint64("index_pos", index_pos);
-        indexHeader.set_uint32("conn_count", static_cast<uint32_t>(connections.size()));
-        indexHeader.set_uint32("chunk_count",static_cast<uint32_t>(
-                               std::count_if(chunks.begin(), chunks.end(), [](const WriteChunk &chunk) {
-                                   return chunk.pos != -1;
-                               })));
-        int size = indexHeader.write(bio, RecordType::BAGHEADER);
-        int padsize = 4096 - 4 - size;
-        bio.write(reinterpret_cast<const char *>(serialize_uint32(padsize).data()), 4);
-        bio.write(std::string(padsize, ' ').c_str(), padsize);
-        opened = false;
+        // A short sidecar would pass the bag size check, so remove it rather than leave a bad index behind
+        bool spillOk = !spill.is_open() || static_cast<bool>(spill);
+        out.close();
+        if (!out || !spillOk) {
+            std::cerr << "Error: could not write " << indexPath << ", removing it" << std::endl;
+            std::filesystem::remove(indexPath, ec);
+        }
     }
 
 
+    bool RosbagWriter::setCompression(CompressionType type) {
+        if (!isCompressionAvailable(type) || !backend->supportsCompression(type)) {
+            std::cerr << "Compression type " << static_cast<int>(type) << " is not available, writing uncompressed chunks"
+                      << std::endl;
+            backend->setCompression(CompressionType::NONE);
+            return false;
+        }
+        backend->setCompression(type);
+        return true;
+    }
+
     Connection RosbagWriter::getConnection(const std::string &topic, const std::string &msgType){
+        std::lock_guard<std::mutex> lock(mutex);
         for (const auto &conn: connections) {
             if (conn.topic == topic && conn.msgType == msgType)
                 return conn;
         }
-        return add_connection(topic, msgType);
+        return register_connection(topic, msgType);
     };
 
     std::vector<uint8_t> RosbagWriter::serializerRosHeader(uint32_t sequence, int64_t currentTimeNs) {
@@ -267,5 +553,13 @@ namespace CRLRosWriter {
         return output;
 
     }
-}
 
+    std::unique_ptr<StorageBackend> createStorageBackend(StorageFormat format) {
+        switch (format) {
+            case StorageFormat::MCAP:
+                return std::make_unique<McapBackend>();
+            default:
+                return std::make_unique<RosbagV2Backend>();
+        }
+    }
+}
@@ -0,0 +1,105 @@
+//
+// Text manifest for striped recordings:
+//
+//   #ROSBAG STRIPES V1
+//   stripe <path relative to the manifest>
+//   topic <stripe> <type> <topic>
+//   chunk <start ns> <end ns> <stripe> <chunk_pos>
+//
+#include <algorithm>
+#include <sstream>
+
+#include "RosbagReader/StripeManifest.h"
+
+namespace CRLRosReader {
+
+    static constexpr const char *MANIFEST_VERSION = "#ROSBAG STRIPES V1";
+
+    std::vector<StripeManifest::Chunk> StripeManifest::query(int64_t start, int64_t end) const {
+        std::vector<Chunk> result;
+        auto last = std::upper_bound(chunks.begin(), chunks.end(), end, [](int64_t time, const Chunk &chunk) {
+            return time < chunk.start;
+        });
+        for (auto it = chunks.begin(); it != last; ++it) {
+            if (it->end >= start)
+                result.push_back(*it);
+        }
+        return result;
+    }
+
+    bool buildStripeManifest(const std::vector<std::filesystem::path> &stripes, StripeManifest &manifest) {
+        manifest = StripeManifest();
+        manifest.stripes = stripes;
+        for (size_t i = 0; i < stripes.size(); ++i) {
+            RosbagReader reader;
+            if (!reader.open(stripes[i]) || !reader.readHeader())
+                return false;
+            auto stripe = static_cast<uint32_t>(i);
+            for (const ConnectionInfo &connection: reader.getConnections())
+                manifest.topics.push_back({stripe, connection.topic, connection.msgType});
+            for (const ChunkInfo &chunk: reader.getChunks())
+                manifest.chunks.push_back({chunk.start, chunk.end, stripe, chunk.pos});
+        }
+        std::stable_sort(manifest.chunks.begin(), manifest.chunks.end(),
+                         [](const StripeManifest::Chunk &a, const StripeManifest::Chunk &b) {
+                             return a.start < b.start;
+                         });
+        return true;
+    }
+
+    bool writeStripeManifest(const std::filesystem::path &filePath, const StripeManifest &manifest) {
+        std::ofstream out(filePath, std::ios::out | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error: Could not open file " << filePath << std::endl;
+            return false;
+        }
+        out << MANIFEST_VERSION << "\n";
+        // Stripe paths are stored relative to the manifest so the set can be moved or mounted elsewhere
+        std::filesystem::path base = filePath.parent_path().empty() ? "." : filePath.parent_path();
+        for (const auto &stripe: manifest.stripes)
+            out << "stripe " << std::filesystem::proximate(stripe, base).string() << "\n";
+        for (const auto &topic: manifest.topics)
+            out << "topic " << topic.stripe << " " << topic.msgType << " " << topic.topic << "\n";
+        for (const auto &chunk: manifest.chunks)
+            out << "chunk " << chunk.start << " " << chunk.end << " " << chunk.stripe << " " << chunk.pos << "\n";
+        return static_cast<bool>(out);
+    }
+
+    bool readStripeManifest(const std::filesystem::path &filePath, StripeManifest &manifest) {
+        std::ifstream in(filePath);
+        std::string line;
+        if (!in || !std::getline(in, line) || line != MANIFEST_VERSION) {
+            std::cerr << "Error: " << filePath << " is not a stripe manifest" << std::endl;
+            return false;
+        }
+
+        manifest = StripeManifest();
+        while (std::getline(in, line)) {
+            std::istringstream ss(line);
+            std::string kind;
+            ss >> kind;
+            if (kind == "stripe") {
+                std::string stripe;
+                std::getline(ss >> std::ws, stripe);
+                std::filesystem::path stripePath(stripe);
+                if (stripePath.is_relative())
+                    stripePath = (filePath.parent_path() / stripePath).lexically_normal();
+                manifest.stripes.push_back(stripePath);
+            } else if (kind == "topic") {
+                StripeManifest::Topic topic;
+                ss >> topic.stripe >> topic.msgType >> topic.topic;
+                manifest.topics.push_back(topic);
+            } else if (kind == "chunk") {
+                StripeManifest::Chunk chunk;
+                ss >> chunk.start >> chunk.end >> chunk.stripe >> chunk.pos;
+                manifest.chunks.push_back(chunk);
+            }
+            if (ss.fail()) {
+                std::cerr << "Error: " << filePath << " has a malformed line: " << line << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
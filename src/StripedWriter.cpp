@@ -0,0 +1,153 @@
+//
+// Multi-disk striped recording on top of RosbagWriter.
+//
+#include <iostream>
+#include <string>
+
+#include <RosbagWriter/StripedWriter.h>
+#include <RosbagReader/StripeManifest.h>
+
+namespace CRLRosWriter {
+
+    void StripedWriter::open(const std::vector<std::filesystem::path> &directories, const std::string &name) {
+        if (opened || directories.empty())
+            return;
+
+        stripe_paths.clear();
+        for (size_t i = 0; i < directories.size(); ++i) {
+            auto stripe = std::make_unique<Stripe>();
+            stripe->writer = std::make_unique<RosbagWriter>();
+            stripe->writer->setChunkThreshold(chunk_threshold);
+            stripe_paths.push_back(directories[i] / (name + "_" + std::to_string(i) + ".bag"));
+            stripe->writer->open(stripe_paths.back());
+            stripes.push_back(std::move(stripe));
+        }
+        manifest_path = directories.front() / (name + ".stripes");
+
+        for (auto &stripe: stripes) {
+            Stripe *ptr = stripe.get();
+            stripe->thread = std::thread([this, ptr]() { run(*ptr); });
+        }
+        std::unique_lock<std::shared_mutex> lock(connections_mutex);
+        opened = true;
+    }
+
+    void StripedWriter::run(Stripe &stripe) {
+        while (true) {
+            std::deque<Message> batch;
+            {
+                std::unique_lock<std::mutex> lock(stripe.mutex);
+                stripe.cv.wait(lock, [&stripe]() { return stripe.stop || !stripe.queue.empty(); });
+                if (stripe.queue.empty() && stripe.stop)
+                    return;
+                batch.swap(stripe.queue);
+            }
+
+            // The queue lock is not held here, so the producer keeps feeding the other stripes while this one flushes
+            uint64_t bytes = 0;
+            for (Message &message: batch) {
+                bytes += message.data.size();
+                stripe.writer->write(*message.connection, message.timestamp, std::move(message.data));
+            }
+
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stripe.queued -= bytes;
+            stripe.cv.notify_all();
+        }
+    }
+
+    Connection StripedWriter::getConnection(const std::string &topic, const std::string &msgType) {
+        std::unique_lock<std::shared_mutex> lock(connections_mutex);
+        for (const auto &[stripe, conn]: connections) {
+            if (conn.topic == topic && conn.msgType == msgType)
+                return add_connection(topic, msgType, stripe);
+        }
+        size_t stripe = next_stripe;
+        next_stripe = (next_stripe + 1) % std::max<size_t>(stripes.size(), 1);
+        return add_connection(topic, msgType, stripe);
+    }
+
+    Connection StripedWriter::getConnection(const std::string &topic, const std::string &msgType, size_t stripe) {
+        std::unique_lock<std::shared_mutex> lock(connections_mutex);
+        return add_connection(topic, msgType, stripe);
+    }
+
+    // Called with connections_mutex held exclusively
+    Connection StripedWriter::add_connection(const std::string &topic, const std::string &msgType, size_t stripe) {
+        if (!opened)
+            return Connection(-1, topic, msgType, "", "", 0);
+        for (size_t id = 0; id < connections.size(); ++id) {
+            const auto &[connStripe, conn] = connections[id];
+            if (conn.topic == topic && conn.msgType == msgType) {
+                Connection global = conn;
+                global.id = static_cast<int>(id);
+                return global;
+            }
+        }
+        if (stripe >= stripes.size()) {
+            std::cerr << "Error: stripe " << stripe << " does not exist" << std::endl;
+            exit(1);
+        }
+
+        Connection local = stripes[stripe]->writer->getConnection(topic, msgType);
+        connections.emplace_back(stripe, local);
+        Connection global = local;
+        global.id = static_cast<int>(connections.size() - 1);
+        return global;
+    }
+
+    void StripedWriter::write(Connection &connection, int64_t timestamp, std::vector<uint8_t> data) {
+        Stripe *stripe = nullptr;
+        Connection *local = nullptr;
+        {
+            // Deque elements and stripes stay in place until close(), so they are used without the lock below
+            std::shared_lock<std::shared_mutex> lock(connections_mutex);
+            if (!opened || connection.id < 0 || static_cast<size_t>(connection.id) >= connections.size())
+                return;
+            auto &[index, conn] = connections[static_cast<size_t>(connection.id)];
+            stripe = stripes[index].get();
+            local = &conn;
+        }
+
+        std::unique_lock<std::mutex> lock(stripe->mutex);
+        stripe->cv.wait(lock, [&]() { return stripe->queued < queue_limit || stripe->queue.empty(); });
+        stripe->queued += data.size();
+        stripe->queue.push_back({local, timestamp, std::move(data)});
+        stripe->cv.notify_all();
+    }
+
+    void StripedWriter::close() {
+        {
+            std::unique_lock<std::shared_mutex> lock(connections_mutex);
+            if (!opened)
+                return;
+            opened = false;
+        }
+
+        for (auto &stripe: stripes) {
+            std::lock_guard<std::mutex> lock(stripe->mutex);
+            stripe->stop = true;
+            stripe->cv.notify_all();
+        }
+        for (auto &stripe: stripes)
+            stripe->thread.join();
+
+        // Final chunk flush and index of each stripe, then merge their indexes into the manifest
+        std::vector<std::thread> closers;
+        for (auto &stripe: stripes)
+            closers.emplace_back([&stripe]() { stripe->writer.reset(); });
+        for (auto &closer: closers)
+            closer.join();
+
+        CRLRosReader::StripeManifest manifest;
+        if (!CRLRosReader::buildStripeManifest(stripe_paths, manifest) ||
+            !CRLRosReader::writeStripeManifest(manifest_path, manifest)) {
+            std::cerr << "Error: could not write stripe manifest " << manifest_path << std::endl;
+        }
+        stripes.clear();
+        std::unique_lock<std::shared_mutex> lock(connections_mutex);
+        connections.clear();
+        next_stripe = 0;
+    }
+
+}
@@ -0,0 +1,146 @@
+//
+// Reader side of the per-connection time index sidecar.
+//
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "RosbagReader/TimeIndex.h"
+
+namespace CRLRosReader {
+
+    using CRLRosWriter::TimeIndexDirectoryEntry;
+    using CRLRosWriter::TimeIndexFileHeader;
+
+    TimeIndex::~TimeIndex() {
+        close();
+    }
+
+    void TimeIndex::close() {
+#ifdef __unix__
+        if (base && buffer.empty())
+            munmap(const_cast<uint8_t *>(base), size);
+#endif
+        buffer.clear();
+        base = nullptr;
+        size = 0;
+        directory = nullptr;
+        connCount = 0;
+    }
+
+    bool TimeIndex::open(const std::filesystem::path &bag) {
+        close();
+        std::filesystem::path path = sidecarPath(bag);
+
+#ifdef __unix__
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            return false;
+        }
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = static_cast<size_t>(st.st_size);
+            void *ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            base = ptr == MAP_FAILED ? nullptr : static_cast<const uint8_t *>(ptr);
+        }
+        ::close(fd);
+        if (!base) {
+            size = 0;
+            return false;
+        }
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            return false;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        base = buffer.data();
+        size = buffer.size();
+#endif
+
+        TimeIndexFileHeader header{};
+        if (size < sizeof(header)) {
+            close();
+            return false;
+        }
+        std::memcpy(&header, base, sizeof(header));
+        std::error_code ec;
+        if (std::memcmp(header.magic, CRLRosWriter::TIME_INDEX_MAGIC, 8) != 0 ||
+            header.connCount > (size - sizeof(header)) / sizeof(TimeIndexDirectoryEntry) ||
+            header.bagSize != std::filesystem::file_size(bag, ec)) {
+            std::cerr << "Error: " << path << " is not a time index for " << bag << std::endl;
+            close();
+            return false;
+        }
+        connCount = header.connCount;
+        directory = reinterpret_cast<const TimeIndexDirectoryEntry *>(base + sizeof(header));
+
+        // The entries are used in place, so every run must be aligned and lie inside the mapping, and find() relies
+        // on the directory being sorted. Checked with divisions, a corrupt count could overflow the multiplication.
+        const uint64_t entriesBegin = sizeof(header) + uint64_t{connCount} * sizeof(TimeIndexDirectoryEntry);
+        for (uint32_t i = 0; i < connCount; ++i) {
+            const TimeIndexDirectoryEntry &entry = directory[i];
+            if (entry.offset < entriesBegin || entry.offset > size || entry.offset % alignof(TimeIndexEntry) != 0 ||
+                entry.count > (size - entry.offset) / sizeof(TimeIndexEntry) ||
+                (i > 0 && directory[i - 1].conn >= entry.conn)) {
+                std::cerr << "Error: " << path << " is truncated or corrupt" << std::endl;
+                close();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const TimeIndexDirectoryEntry *TimeIndex::find(uint32_t conn) const {
+        auto last = directory + connCount;
+        auto it = std::lower_bound(directory, last, conn, [](const TimeIndexDirectoryEntry &entry, uint32_t id) {
+            return entry.conn < id;
+        });
+        return it != last && it->conn == conn ? it : nullptr;
+    }
+
+    std::vector<uint32_t> TimeIndex::getConnections() const {
+        std::vector<uint32_t> result;
+        for (uint32_t i = 0; i < connCount; ++i)
+            result.push_back(directory[i].conn);
+        return result;
+    }
+
+    size_t TimeIndex::count(uint32_t conn) const {
+        auto entry = find(conn);
+        return entry ? static_cast<size_t>(entry->count) : 0;
+    }
+
+    const TimeIndexEntry *TimeIndex::begin(uint32_t conn) const {
+        auto entry = find(conn);
+        return entry ? reinterpret_cast<const TimeIndexEntry *>(base + entry->offset) : nullptr;
+    }
+
+    const TimeIndexEntry *TimeIndex::end(uint32_t conn) const {
+        auto entry = find(conn);
+        return entry ? reinterpret_cast<const TimeIndexEntry *>(base + entry->offset) + entry->count : nullptr;
+    }
+
+    const TimeIndexEntry *TimeIndex::seek(uint32_t conn, int64_t time) const {
+        const TimeIndexEntry *first = begin(conn);
+        const TimeIndexEntry *last = end(conn);
+        if (!first)
+            return nullptr;
+        auto it = std::lower_bound(first, last, time, [](const TimeIndexEntry &entry, int64_t t) {
+            return entry.time < t;
+        });
+        return it == last ? nullptr : it;
+    }
+
+}
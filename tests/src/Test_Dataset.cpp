@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagReader/BagDataset.h"
+
+static const int64_t T0 = 1'700'000'000'000'000'000;
+
+// Three split bags of 300 messages each, the last one also holds a topic the others don't have
+static void writeSplitBags(const std::filesystem::path &dir) {
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    int i = 0;
+    for (int part: {0, 1, 2}) {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.open(dir / ("run_" + std::to_string(part == 2 ? 10 : part) + ".bag"));
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        for (int n = 0; n < 300; ++n, ++i) {
+            std::vector<uint8_t> data(100, static_cast<uint8_t>(part));
+            writer.write(i % 3 ? conn : conn2, T0 + i * 1000, data);
+        }
+        if (part == 2) {
+            auto extra = writer.getConnection("/extra", "std_msgs/String");
+            writer.write(extra, T0 + 5, std::vector<uint8_t>(8, 9));
+        }
+    }
+}
+
+TEST(DatasetTests, MergedIndexAndSummary) {
+    writeSplitBags("dataset");
+    CRLRosReader::BagDataset dataset(2);
+    ASSERT_TRUE(dataset.openDirectory("dataset", 4));
+    ASSERT_EQ(dataset.getBags().size(), 3u);
+    ASSERT_EQ(dataset.getBags()[2].filename(), "run_10.bag");
+    ASSERT_EQ(dataset.getConnections().size(), 3u);
+    ASSERT_EQ(dataset.openFiles(), 0u);
+
+    CRLRosReader::BagSummary summary = dataset.summary();
+    ASSERT_EQ(summary.messageCount, 901u);
+    ASSERT_EQ(summary.start, T0);
+    ASSERT_EQ(summary.end, T0 + 899 * 1000);
+    ASSERT_EQ(summary.topics.size(), 3u);
+    ASSERT_TRUE(std::is_sorted(dataset.getChunks().begin(), dataset.getChunks().end(),
+                               [](const auto &a, const auto &b) { return a.start < b.start; }));
+
+    // Only chunks of the last bag hold /extra
+    auto chunks = dataset.query(T0, T0 + 1'000'000, {"/extra"});
+    ASSERT_EQ(chunks.size(), 1u);
+    ASSERT_EQ(chunks[0]->bag, 2u);
+}
+
+TEST(DatasetTests, OrderedIterationAcrossFiles) {
+    writeSplitBags("dataset_iter");
+    CRLRosReader::BagDataset dataset(2);
+    ASSERT_TRUE(dataset.openDirectory("dataset_iter"));
+
+    auto cursor = dataset.messages();
+    CRLRosReader::DatasetMessage message;
+    uint64_t count = 0;
+    int64_t last = 0;
+    bool sawExtra = false;
+    while (cursor.next(message)) {
+        ASSERT_GE(message.time, last);
+        last = message.time;
+        sawExtra |= message.connection->topic == "/extra";
+        ASSERT_LE(dataset.openFiles(), 2u);
+        ++count;
+    }
+    ASSERT_FALSE(cursor.failed());
+    ASSERT_EQ(count, 901u);
+    // The /extra message is stamped before everything else in run_10.bag
+    ASSERT_TRUE(sawExtra);
+
+    // Time and topic filter spanning the boundary between the first two bags
+    cursor = dataset.messages(T0 + 250 * 1000, T0 + 349 * 1000, {"/temperature"});
+    count = 0;
+    while (cursor.next(message)) {
+        ASSERT_EQ(message.connection->topic, "/temperature");
+        ASSERT_EQ(message.size(), 100u);
+        ASSERT_EQ(message.data()[0], message.time < T0 + 300 * 1000 ? 0 : 1);
+        ++count;
+    }
+    ASSERT_EQ(count, 33u);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagWriter/RosbagV2Backend.h"
+#include "RosbagReader/RosbagReader.h"
+
+TEST(DurabilityTests, FutureCompletesAfterSync) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setDurability(std::chrono::milliseconds(2));
+        writer.open("durable.bag");
+        auto conn = writer.getConnection("/safety", "std_msgs/String");
+        std::vector<uint8_t> data(64, 0x42);
+
+        auto future = writer.writeDurable(conn, t0, data);
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        ASSERT_TRUE(future.get());
+        // The chunk was sealed early and is on disk before close
+        ASSERT_GT(std::filesystem::file_size("durable.bag"), 4096u + 13u + 64u);
+    }
+
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("durable.bag", summary));
+    ASSERT_EQ(summary.messageCount, 1u);
+}
+
+TEST(DurabilityTests, SyncsAreGrouped) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    std::atomic<int> completed{0};
+    std::atomic<int> failed{0};
+    uint64_t syncs;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setDurability(std::chrono::milliseconds(50));
+        writer.open("durable_group.bag");
+        auto conn = writer.getConnection("/safety", "std_msgs/String");
+        auto conn2 = writer.getConnection("/chatter", "std_msgs/String");
+        std::vector<uint8_t> data(64, 0x42);
+        for (int i = 0; i < 200; ++i) {
+            writer.write(conn2, t0 + i, data);
+            writer.writeDurable(conn, t0 + i, data, [&](bool ok) {
+                ok ? ++completed : ++failed;
+            });
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (completed + failed < 200 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        syncs = writer.getSyncCount();
+    }
+    ASSERT_EQ(completed.load(), 200);
+    ASSERT_EQ(failed.load(), 0);
+    // 200 durable writes well inside one commit window share a handful of syncs
+    ASSERT_GE(syncs, 1u);
+    ASSERT_LT(syncs, 20u);
+
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("durable_group.bag", summary));
+    ASSERT_EQ(summary.messageCount, 400u);
+}
+
+TEST(DurabilityTests, FailsWithoutDurabilityMode) {
+    CRLRosWriter::RosbagWriter writer;
+    writer.open("durable_off.bag");
+    auto conn = writer.getConnection("/safety", "std_msgs/String");
+    auto future = writer.writeDurable(conn, 1, std::vector<uint8_t>(8, 0));
+    ASSERT_FALSE(future.get());
+}
+
+// ROS 1 backend with a 64 KiB chunk limit, so oversized messages can be tested without 4 GiB buffers
+class SmallChunkBackend : public CRLRosWriter::RosbagV2Backend {
+public:
+    uint64_t maxChunkSize() const override { return 64 * 1024 + CRLRosWriter::MESSAGE_RECORD_OVERHEAD; }
+};
+
+TEST(DurabilityTests, DroppedMessageIsNotDurable) {
+    {
+        CRLRosWriter::RosbagWriter writer(std::make_unique<SmallChunkBackend>());
+        writer.setDurability(std::chrono::milliseconds(1));
+        writer.open("durable_dropped.bag");
+        auto conn = writer.getConnection("/safety", "std_msgs/String");
+        auto dropped = writer.writeDurable(conn, 1, std::vector<uint8_t>(128 * 1024, 0));
+        auto kept = writer.writeDurable(conn, 2, std::vector<uint8_t>(1024, 0));
+        ASSERT_FALSE(dropped.get());
+        ASSERT_TRUE(kept.get());
+    }
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("durable_dropped.bag", summary));
+    ASSERT_EQ(summary.messageCount, 1u);
+}
+
+// Every commit ends the open chunk, so N durable writes that each wait for their commit give N chunks, while
+// writes sharing a commit window share a chunk
+TEST(DurabilityTests, ChunkCountFollowsCommits) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    uint64_t syncs;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setDurability(std::chrono::microseconds(100));
+        writer.open("durable_chunks.bag");
+        auto conn = writer.getConnection("/safety", "std_msgs/String");
+        std::vector<uint8_t> data(64, 0x42);
+        for (int i = 0; i < 20; ++i)
+            ASSERT_TRUE(writer.writeDurable(conn, t0 + i, data).get());
+
+        std::vector<std::future<bool>> futures;
+        for (int i = 20; i < 220; ++i)
+            futures.push_back(writer.writeDurable(conn, t0 + i, data));
+        for (auto &future: futures)
+            ASSERT_TRUE(future.get());
+        syncs = writer.getSyncCount();
+    }
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("durable_chunks.bag", summary));
+    ASSERT_EQ(summary.messageCount, 220u);
+    // One chunk per commit: 20 for the waited writes, the queued 200 share a few
+    ASSERT_EQ(summary.chunkCount, syncs);
+    ASSERT_GE(summary.chunkCount, 21u);
+    ASSERT_LT(summary.chunkCount, 120u);
+}
+
+TEST(DurabilityTests, ConcurrentConnectionsGetUniqueIds) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setDurability(std::chrono::microseconds(200));
+        writer.open("durable_connections.bag");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&writer, t, t0]() {
+                std::vector<uint8_t> data(64, static_cast<uint8_t>(t));
+                for (int i = 0; i < 50; ++i) {
+                    auto conn = writer.getConnection("/topic_" + std::to_string((t + i) % 8), "std_msgs/String");
+                    writer.writeDurable(conn, t0 + i, data, [](bool) {});
+                }
+            });
+        }
+        for (auto &thread: threads)
+            thread.join();
+    }
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open("durable_connections.bag"));
+    ASSERT_TRUE(reader.readHeader());
+    ASSERT_EQ(reader.getConnections().size(), 8u);
+    for (size_t i = 0; i < reader.getConnections().size(); ++i)
+        ASSERT_EQ(reader.getConnections()[i].id, i);
+    ASSERT_EQ(reader.summary().messageCount, 200u);
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/MessageDecoders.h"
+#include "RosbagReader/BagExport.h"
+
+static std::vector<uint8_t> temperatureMessage(uint32_t seq, int64_t stamp, double temperature) {
+    std::vector<uint8_t> out = CRLRosWriter::serialize_uint32(seq);
+    for (auto part: {CRLRosWriter::serialize_uint32(static_cast<uint32_t>(stamp / 1'000'000'000)),
+                     CRLRosWriter::serialize_uint32(static_cast<uint32_t>(stamp % 1'000'000'000)),
+                     CRLRosWriter::serialize_uint32(0)})
+        out.insert(out.end(), part.begin(), part.end());
+    uint64_t raw[2];
+    double values[2] = {temperature, 0.5};
+    std::memcpy(raw, values, sizeof(raw));
+    for (uint64_t value: raw) {
+        auto bytes = CRLRosWriter::serialize_uint64(value);
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+    return out;
+}
+
+static void writeExportBag(const std::string &path) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    CRLRosWriter::RosbagWriter writer;
+    writer.setChunkThreshold(8192);
+    writer.open(path);
+    auto camera = writer.getConnection("/camera/image", "sensor_msgs/Image");
+    auto temperature = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+    std::vector<uint8_t> pixels(16 * 8 * 3);
+    for (int i = 0; i < 40; ++i) {
+        std::fill(pixels.begin(), pixels.end(), static_cast<uint8_t>(i));
+        writer.write(camera, t0 + i * 1'000'000,
+                     writer.serializeImage(i, t0 + i * 1'000'000, 16, 8, pixels.data(),
+                                           static_cast<uint32_t>(pixels.size()), "rgb8", 16 * 3));
+        writer.write(temperature, t0 + i * 1'000'000, temperatureMessage(i, t0 + i * 1'000'000, 20.0 + i));
+    }
+}
+
+TEST(ExportTests, DecodesSerializedImage) {
+    std::vector<uint8_t> pixels(4 * 2, 7);
+    CRLRosWriter::RosbagWriter writer;
+    std::vector<uint8_t> bytes = writer.serializeImage(3, 1'000'000'123, 4, 2, pixels.data(), 8, "mono8", 4);
+
+    CRLRosReader::ImageMessage image;
+    ASSERT_TRUE(CRLRosReader::decodeImage(bytes, 0, bytes.size(), image));
+    ASSERT_EQ(image.header.seq, 3u);
+    ASSERT_EQ(image.header.stamp, 1'000'000'123);
+    ASSERT_EQ(image.width, 4u);
+    ASSERT_EQ(image.height, 2u);
+    ASSERT_EQ(image.encoding, "mono8");
+    ASSERT_EQ(image.dataSize, 8u);
+    ASSERT_EQ(image.data[7], 7);
+    ASSERT_FALSE(CRLRosReader::decodeImage(bytes, 0, bytes.size() - 1, image));
+}
+
+TEST(ExportTests, ExportsImagesAndCsvInOrder) {
+    writeExportBag("export.bag");
+    std::filesystem::remove_all("export_out");
+
+    CRLRosReader::ExportOptions options;
+    options.outputDir = "export_out";
+    options.threads = 4;
+    CRLRosReader::ExportResult result;
+    ASSERT_TRUE(CRLRosReader::exportBag("export.bag", options, result));
+    ASSERT_TRUE(result.failedChunks.empty());
+    ASSERT_EQ(result.images, 40u);
+    ASSERT_EQ(result.rows, 40u);
+    ASSERT_EQ(result.skipped, 0u);
+
+    size_t files = 0;
+    for (const auto &entry: std::filesystem::directory_iterator("export_out/camera_image")) {
+        (void) entry;
+        ++files;
+    }
+    ASSERT_EQ(files, 40u);
+
+    std::ifstream csv("export_out/temperature.csv");
+    std::string line;
+    std::getline(csv, line);
+    ASSERT_EQ(line, "time,seq,stamp,temperature,variance");
+    for (int i = 0; i < 40; ++i) {
+        ASSERT_TRUE(std::getline(csv, line));
+        std::istringstream fields(line);
+        std::string time, seq;
+        std::getline(fields, time, ',');
+        std::getline(fields, seq, ',');
+        ASSERT_EQ(seq, std::to_string(i));
+    }
+}
+
+TEST(ExportTests, BinaryArrays) {
+    writeExportBag("export_bin.bag");
+    std::filesystem::remove_all("export_bin_out");
+
+    CRLRosReader::ExportOptions options;
+    options.outputDir = "export_bin_out";
+    options.threads = 3;
+    options.binary = true;
+    options.topics = {"/temperature"};
+    CRLRosReader::ExportResult result;
+    ASSERT_TRUE(CRLRosReader::exportBag("export_bin.bag", options, result));
+    ASSERT_EQ(result.images, 0u);
+    ASSERT_EQ(result.rows, 40u);
+
+    // time, seq, stamp, temperature, variance
+    ASSERT_EQ(std::filesystem::file_size("export_bin_out/temperature.bin"), 40u * 5 * 8);
+    std::ifstream bin("export_bin_out/temperature.bin", std::ios::binary);
+    std::vector<char> rows(40 * 5 * 8);
+    bin.read(rows.data(), static_cast<std::streamsize>(rows.size()));
+    double temperature;
+    std::memcpy(&temperature, rows.data() + 39 * 40 + 24, sizeof(temperature));
+    ASSERT_DOUBLE_EQ(temperature, 59.0);
+}
+
+// Many small chunks over more threads than the commit window, the rows must still come out in order
+TEST(ExportTests, ScalarRowsInOrderAcrossManyChunks) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(512);
+        writer.open("export_many.bag");
+        auto temperature = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        for (int i = 0; i < 3000; ++i)
+            writer.write(temperature, t0 + i, temperatureMessage(i, t0 + i, 20.0));
+    }
+    std::filesystem::remove_all("export_many_out");
+
+    CRLRosReader::ExportOptions options;
+    options.outputDir = "export_many_out";
+    options.threads = 8;
+    CRLRosReader::ExportResult result;
+    ASSERT_TRUE(CRLRosReader::exportBag("export_many.bag", options, result));
+    ASSERT_EQ(result.rows, 3000u);
+
+    std::ifstream csv("export_many_out/temperature.csv");
+    std::string line;
+    std::getline(csv, line);
+    for (int i = 0; i < 3000; ++i) {
+        ASSERT_TRUE(std::getline(csv, line));
+        ASSERT_EQ(line.substr(line.find(',') + 1, line.find(',', line.find(',') + 1) - line.find(',') - 1),
+                  std::to_string(i));
+    }
+    ASSERT_FALSE(std::getline(csv, line));
+}
+
+// /a/b and /a_b both map to a_b, the second topic must not be interleaved into the first one's file
+TEST(ExportTests, CollidingTopicNames) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.open("export_collide.bag");
+        auto nested = writer.getConnection("/a/b", "sensor_msgs/Temperature");
+        auto flat = writer.getConnection("/a_b", "sensor_msgs/Temperature");
+        for (int i = 0; i < 20; ++i)
+            writer.write(i % 2 ? flat : nested, t0 + i, temperatureMessage(i, t0 + i, 20.0));
+    }
+    std::filesystem::remove_all("export_collide_out");
+
+    CRLRosReader::ExportOptions options;
+    options.outputDir = "export_collide_out";
+    CRLRosReader::ExportResult result;
+    ASSERT_TRUE(CRLRosReader::exportBag("export_collide.bag", options, result));
+    ASSERT_EQ(result.rows, 20u);
+
+    for (const auto &[file, first]: {std::pair<std::string, int>{"a_b.csv", 0}, {"a_b_1.csv", 1}}) {
+        std::ifstream csv("export_collide_out/" + file);
+        ASSERT_TRUE(csv.is_open()) << file;
+        std::string line;
+        std::getline(csv, line);
+        for (int i = first; i < 20; i += 2) {
+            ASSERT_TRUE(std::getline(csv, line));
+            ASSERT_EQ(line.substr(line.find(',') + 1, line.find(',', line.find(',') + 1) - line.find(',') - 1),
+                      std::to_string(i));
+        }
+        ASSERT_FALSE(std::getline(csv, line));
+    }
+}
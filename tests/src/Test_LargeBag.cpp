@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagWriter/RosbagV2Backend.h"
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/TimeIndex.h"
+
+// ROS 1 backend that leaves a sparse hole after the bag header, so every chunk RosbagWriter writes lands past
+// 4 GiB without writing 4 GiB of data
+class SparseBackend : public CRLRosWriter::RosbagV2Backend {
+public:
+    static constexpr uint64_t HOLE = 5ULL << 30;
+
+    void writeHeader(std::ostream &bio) override {
+        CRLRosWriter::RosbagV2Backend::writeHeader(bio);
+        bio.seekp(static_cast<std::streamoff>(HOLE));
+    }
+};
+
+TEST(LargeBagTests, SparseOffsetsPast4GB) {
+    const std::filesystem::path path = "sparse_large.bag";
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer(std::make_unique<SparseBackend>());
+        writer.setChunkThreshold(4096);
+        writer.setTimeIndex(true);
+        writer.open(path);
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        for (int i = 0; i < 300; ++i)
+            writer.write(i % 3 ? conn : conn2, t0 + i, std::vector<uint8_t>(64, static_cast<uint8_t>(i)));
+    }
+    ASSERT_GT(std::filesystem::file_size(path), 4ULL << 30);
+
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_TRUE(reader.readHeader());
+    ASSERT_GT(reader.getChunks().size(), 2u);
+    ASSERT_EQ(reader.getChunks()[0].pos, SparseBackend::HOLE);
+    ASSERT_EQ(reader.summary().messageCount, 300u);
+
+    // Chunk records are found at their 64-bit CHUNK_INFO offsets and hold every message in order
+    int next = 0;
+    for (const CRLRosReader::ChunkInfo &info: reader.getChunks()) {
+        ASSERT_GE(info.pos, SparseBackend::HOLE);
+        CRLRosReader::ChunkRecord chunk;
+        std::vector<CRLRosReader::MessageRecord> messages;
+        ASSERT_TRUE(reader.readChunk(info.pos, chunk));
+        ASSERT_TRUE(CRLRosReader::decompressChunk(chunk));
+        ASSERT_TRUE(CRLRosReader::parseMessages(chunk.data, messages));
+        for (const CRLRosReader::MessageRecord &message: messages) {
+            ASSERT_EQ(message.time, t0 + next);
+            ASSERT_EQ(message.conn, next % 3 ? 0u : 1u);
+            ASSERT_EQ(chunk.data[message.begin], static_cast<uint8_t>(next));
+            ++next;
+        }
+    }
+    ASSERT_EQ(next, 300);
+
+    CRLRosReader::TimeIndex index;
+    ASSERT_TRUE(index.open(path));
+    ASSERT_EQ(index.count(0) + index.count(1), 300u);
+    ASSERT_GE(index.begin(1)->chunkPos, SparseBackend::HOLE);
+    index.close();
+    std::filesystem::remove(path);
+    std::filesystem::remove(CRLRosReader::TimeIndex::sidecarPath(path));
+}
+
+TEST(LargeBagTests, PreallocationIsTrimmedOnClose) {
+    const std::filesystem::path path = "preallocated.bag";
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(1 << 16);
+        writer.setPreallocation(64 << 20);
+        writer.open(path);
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        std::vector<uint8_t> data(1024, 0x22);
+        for (int i = 0; i < 200; ++i)
+            writer.write(conn, 1'700'000'000'000'000'000 + i, data);
+    }
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary(path, summary));
+    ASSERT_EQ(summary.messageCount, 200u);
+    ASSERT_LT(std::filesystem::file_size(path), 1u << 20);
+#ifdef __linux__
+    // The 64 MiB reserved past EOF must have been released
+    struct stat st{};
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    ASSERT_LT(static_cast<uint64_t>(st.st_blocks) * 512, 1u << 20);
+#endif
+}
+
+// ROS bag v2 chunk sizes and message offsets are uint32, larger thresholds would silently truncate them
+TEST(LargeBagTests, ChunkThresholdIsClampedToFormatLimit) {
+    CRLRosWriter::RosbagWriter mcap(CRLRosWriter::StorageFormat::MCAP);
+    ASSERT_TRUE(mcap.setChunkThreshold(8ULL << 30));
+
+    const std::filesystem::path path = "clamped_threshold.bag";
+    {
+        CRLRosWriter::RosbagWriter writer;
+        ASSERT_TRUE(writer.setChunkThreshold(1ULL << 31));
+        ASSERT_FALSE(writer.setChunkThreshold(std::numeric_limits<uint64_t>::max()));
+        ASSERT_FALSE(writer.setChunkThreshold(4ULL << 30));
+        writer.open(path);
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        for (int i = 0; i < 10; ++i)
+            writer.write(conn, 1'700'000'000'000'000'000 + i, std::vector<uint8_t>(64, 0x33));
+    }
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary(path, summary));
+    ASSERT_EQ(summary.messageCount, 10u);
+    ASSERT_EQ(summary.chunkCount, 1u);
+}
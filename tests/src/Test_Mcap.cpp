@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagWriter/McapBackend.h"
+
+namespace {
+    uint64_t read_uint64(const std::string &buf, size_t pos) {
+        uint64_t val = 0;
+        for (int i = 0; i < 8; ++i)
+            val |= static_cast<uint64_t>(static_cast<uint8_t>(buf[pos + i])) << (i * 8);
+        return val;
+    }
+
+    uint32_t read_uint32(const std::string &buf, size_t pos) {
+        uint32_t val = 0;
+        for (int i = 0; i < 4; ++i)
+            val |= static_cast<uint32_t>(static_cast<uint8_t>(buf[pos + i])) << (i * 8);
+        return val;
+    }
+
+    std::string read_file(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    void write_bag(const std::string &path, CRLRosWriter::CompressionType compression, int messages) {
+        CRLRosWriter::RosbagWriter writer(CRLRosWriter::StorageFormat::MCAP);
+        writer.setCompression(compression);
+        writer.open(path);
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        std::vector<uint8_t> data(64, 0xAB);
+        for (int i = 0; i < messages; ++i) {
+            writer.write(i % 2 ? conn : conn2, 1'700'000'000'000'000'000 + i, data);
+        }
+    }
+}
+
+TEST(McapTests, MagicAndSummary) {
+    write_bag("summary.mcap", CRLRosWriter::CompressionType::NONE, 10);
+    std::string buf = read_file("summary.mcap");
+    ASSERT_GT(buf.size(), 16u);
+    ASSERT_EQ(0, std::memcmp(buf.data(), CRLRosWriter::MCAP_MAGIC, 8));
+    ASSERT_EQ(0, std::memcmp(buf.data() + buf.size() - 8, CRLRosWriter::MCAP_MAGIC, 8));
+
+    // Footer: opcode, length, summary_start, summary_offset_start, summary_crc
+    size_t footer = buf.size() - 8 - 29;
+    ASSERT_EQ(static_cast<uint8_t>(buf[footer]), static_cast<uint8_t>(CRLRosWriter::McapOpcode::FOOTER));
+    uint64_t summaryStart = read_uint64(buf, footer + 9);
+    uint64_t summaryOffsetStart = read_uint64(buf, footer + 17);
+    ASSERT_LT(summaryStart, summaryOffsetStart);
+
+    bool foundStatistics = false;
+    int chunkIndexes = 0;
+    for (size_t pos = summaryStart; pos < summaryOffsetStart;) {
+        auto opcode = static_cast<CRLRosWriter::McapOpcode>(buf[pos]);
+        uint64_t length = read_uint64(buf, pos + 1);
+        if (opcode == CRLRosWriter::McapOpcode::STATISTICS) {
+            foundStatistics = true;
+            ASSERT_EQ(read_uint64(buf, pos + 9), 10u);                 // message_count
+            ASSERT_EQ(read_uint32(buf, pos + 9 + 10), 2u);             // channel_count
+            ASSERT_EQ(read_uint32(buf, pos + 9 + 22), 1u);             // chunk_count
+        } else if (opcode == CRLRosWriter::McapOpcode::CHUNK_INDEX) {
+            ++chunkIndexes;
+            uint64_t chunkStart = read_uint64(buf, pos + 9 + 16);
+            ASSERT_EQ(static_cast<uint8_t>(buf[chunkStart]), static_cast<uint8_t>(CRLRosWriter::McapOpcode::CHUNK));
+        }
+        pos += 9 + length;
+    }
+    ASSERT_TRUE(foundStatistics);
+    ASSERT_EQ(chunkIndexes, 1);
+}
+
+TEST(McapTests, CompressedChunkRoundTrip) {
+    if (!CRLRosWriter::isCompressionAvailable(CRLRosWriter::CompressionType::ZSTD))
+        GTEST_SKIP() << "zstd not available";
+
+    write_bag("compressed.mcap", CRLRosWriter::CompressionType::ZSTD, 100);
+    std::string buf = read_file("compressed.mcap");
+    // The header record follows the magic; the first chunk follows the header
+    size_t chunk = 8 + 9 + read_uint64(buf, 9);
+    ASSERT_EQ(static_cast<uint8_t>(buf[chunk]), static_cast<uint8_t>(CRLRosWriter::McapOpcode::CHUNK));
+    uint64_t uncompressedSize = read_uint64(buf, chunk + 9 + 16);
+    uint32_t compressionLength = read_uint32(buf, chunk + 9 + 28);
+    ASSERT_EQ(buf.substr(chunk + 9 + 32, compressionLength), "zstd");
+    size_t recordsPos = chunk + 9 + 32 + compressionLength;
+    uint64_t recordsLength = read_uint64(buf, recordsPos);
+    ASSERT_LT(recordsLength, uncompressedSize);
+
+    std::string records;
+    ASSERT_TRUE(CRLRosWriter::decompress(CRLRosWriter::CompressionType::ZSTD, buf.substr(recordsPos + 8, recordsLength),
+                                         records, uncompressedSize));
+    ASSERT_EQ(static_cast<uint8_t>(records[0]), static_cast<uint8_t>(CRLRosWriter::McapOpcode::SCHEMA));
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/TimeIndex.h"
+
+static const int64_t T0 = 1'700'000'000'000'000'000;
+
+static CRLRosWriter::MemoryUsage writeBag(const std::string &path, uint64_t budget, bool timeIndex) {
+    CRLRosWriter::RosbagWriter writer;
+    writer.setMemoryBudget(budget);
+    writer.setTimeIndex(timeIndex);
+    writer.open(path);
+    auto conn = writer.getConnection("/chatter", "std_msgs/String");
+    auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+    std::vector<uint8_t> data(1024, 0x11);
+    for (int i = 0; i < 4000; ++i)
+        writer.write(i % 4 ? conn : conn2, T0 + i * 1000, data);
+    return writer.getMemoryUsage();
+}
+
+TEST(MemoryBudgetTests, SealsEarlyToStayInBudget) {
+    const uint64_t budget = 256 * 1024;
+    CRLRosWriter::MemoryUsage usage = writeBag("budget.bag", budget, false);
+    ASSERT_EQ(usage.budget, budget);
+    ASSERT_GT(usage.earlySeals, 0u);
+    ASSERT_FALSE(usage.unattainable);
+    // The estimate goes over the budget by at most one message before the chunk is written out
+    ASSERT_LE(usage.peak, budget + 4 * 1100);
+
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("budget.bag", summary));
+    ASSERT_EQ(summary.messageCount, 4000u);
+    ASSERT_EQ(summary.topics.size(), 2u);
+}
+
+// A long recording must not degrade to one message per chunk once the chunk records add up
+TEST(MemoryBudgetTests, LongRecordingKeepsChunkSize) {
+    const uint64_t budget = 1 << 20;
+    CRLRosWriter::MemoryUsage usage;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setMemoryBudget(budget);
+        writer.open("budget_long.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        std::vector<uint8_t> data(1024, 0x33);
+        for (int i = 0; i < 50'000; ++i)
+            writer.write(conn, T0 + i * 1000, data);
+        usage = writer.getMemoryUsage();
+    }
+    ASSERT_FALSE(usage.unattainable);
+    ASSERT_LE(usage.peak, budget + 4 * 1100);
+    // ~51 MB of messages, the budget allows chunks of about a third of it
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("budget_long.bag", summary));
+    ASSERT_EQ(summary.messageCount, 50'000u);
+    ASSERT_GE(summary.chunkCount, 51'200'000u / (budget / 3));
+    ASSERT_LE(summary.chunkCount, 51'200'000u / (budget / 4));
+    ASSERT_EQ(usage.earlySeals + 1, summary.chunkCount);
+}
+
+TEST(MemoryBudgetTests, UnattainableBudgetIsReported) {
+    CRLRosWriter::MemoryUsage usage;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setMemoryBudget(16 * 1024);
+        writer.open("budget_tiny.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        std::vector<uint8_t> data(1024, 0x44);
+        for (int i = 0; i < 20'000; ++i)
+            writer.write(conn, T0 + i * 1000, data);
+        usage = writer.getMemoryUsage();
+    }
+    ASSERT_TRUE(usage.unattainable);
+    // Chunks stay at the 64 KiB minimum instead of shrinking to single messages
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("budget_tiny.bag", summary));
+    ASSERT_EQ(summary.messageCount, 20'000u);
+    ASSERT_LE(summary.chunkCount, 20'000u * 1060 / (64 * 1024) + 1);
+}
+
+TEST(MemoryBudgetTests, WrittenChunksAreReleased) {
+    CRLRosWriter::RosbagWriter writer;
+    writer.setChunkThreshold(16 * 1024);
+    writer.open("budget_release.bag");
+    auto conn = writer.getConnection("/chatter", "std_msgs/String");
+    std::vector<uint8_t> data(1024, 0x22);
+    for (int i = 0; i < 4000; ++i)
+        writer.write(conn, T0 + i, data);
+    // ~4 MB written, only the open chunk and small per-chunk records remain
+    CRLRosWriter::MemoryUsage usage = writer.getMemoryUsage();
+    ASSERT_LT(usage.total(), 512u * 1024);
+    ASSERT_EQ(usage.earlySeals, 0u);
+}
+
+TEST(MemoryBudgetTests, SpilledTimeIndexMatches) {
+    writeBag("budget_tidx_ref.bag", 0, true);
+    CRLRosWriter::MemoryUsage usage = writeBag("budget_tidx.bag", 64 * 1024, true);
+    ASSERT_GT(usage.spilledEntries, 0u);
+    ASSERT_FALSE(std::filesystem::exists("budget_tidx.bag.tidx.spill"));
+
+    CRLRosReader::TimeIndex index;
+    ASSERT_TRUE(index.open("budget_tidx.bag"));
+    ASSERT_EQ(index.count(0), 3000u);
+    ASSERT_EQ(index.count(1), 1000u);
+    const CRLRosReader::TimeIndexEntry *entry = index.seek(1, T0 + 2001 * 1000);
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->time, T0 + 2004 * 1000);
+
+    // Same message times as without a budget; chunk positions differ because of the early seals
+    CRLRosReader::TimeIndex reference;
+    ASSERT_TRUE(reference.open("budget_tidx_ref.bag"));
+    for (uint32_t conn: {0u, 1u}) {
+        ASSERT_EQ(index.count(conn), reference.count(conn));
+        for (size_t i = 0; i < index.count(conn); ++i)
+            ASSERT_EQ(index.begin(conn)[i].time, reference.begin(conn)[i].time);
+    }
+}
+
+// A spill file that cannot be created disables spilling with a single warning, the index stays complete
+TEST(MemoryBudgetTests, SpillFailureWarnsOnce) {
+    std::filesystem::remove_all("budget_nospill.bag.tidx.spill");
+    std::filesystem::create_directories("budget_nospill.bag.tidx.spill/blocked");
+
+    testing::internal::CaptureStderr();
+    CRLRosWriter::MemoryUsage usage = writeBag("budget_nospill.bag", 64 * 1024, true);
+    std::string log = testing::internal::GetCapturedStderr();
+    ASSERT_EQ(usage.spilledEntries, 0u);
+    size_t warnings = 0;
+    for (size_t pos = log.find("budget_nospill.bag.tidx.spill"); pos != std::string::npos;
+         pos = log.find("budget_nospill.bag.tidx.spill", pos + 1))
+        ++warnings;
+    ASSERT_EQ(warnings, 1u);
+
+    CRLRosReader::TimeIndex index;
+    ASSERT_TRUE(index.open("budget_nospill.bag"));
+    ASSERT_EQ(index.count(0), 3000u);
+    ASSERT_EQ(index.count(1), 1000u);
+    std::filesystem::remove_all("budget_nospill.bag.tidx.spill");
+}
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagReader/Player.h"
+
+static const int64_t T0 = 1'700'000'000'000'000'000;
+
+// 200 messages 1 ms apart on two topics
+static void writeBag(const std::filesystem::path &path) {
+    CRLRosWriter::RosbagWriter writer;
+    writer.setChunkThreshold(2048);
+    writer.open(path);
+    auto conn = writer.getConnection("/chatter", "std_msgs/String");
+    auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+    for (int i = 0; i < 200; ++i) {
+        std::vector<uint8_t> data(64, static_cast<uint8_t>(i));
+        writer.write(i % 2 ? conn : conn2, T0 + i * 1'000'000LL, data);
+    }
+}
+
+TEST(PlaybackTests, PacedDelivery) {
+    writeBag("playback.bag");
+    CRLRosReader::PlaybackOptions options;
+    options.rate = 2.0;
+    options.prefetchBytes = 4096; // forces the I/O thread to refill while playing
+    CRLRosReader::Player player(options);
+    ASSERT_TRUE(player.open("playback.bag"));
+
+    std::vector<int64_t> times;
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_TRUE(player.play([&](const CRLRosReader::DatasetMessage &message) { times.push_back(message.time); }));
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    ASSERT_EQ(times.size(), 200u);
+    ASSERT_TRUE(std::is_sorted(times.begin(), times.end()));
+    // 199 ms of recording at twice the speed
+    ASSERT_GE(elapsed, std::chrono::microseconds(99'500));
+    ASSERT_LT(elapsed, std::chrono::seconds(2));
+
+    CRLRosReader::PlaybackStats stats = player.getStats();
+    ASSERT_EQ(stats.delivered, 200u);
+    ASSERT_LE(stats.percentile(0.5), stats.percentile(0.99));
+    ASSERT_LE(stats.percentile(0.99), stats.maxLateness);
+    // Loose bound, shared CI machines are not real-time systems
+    ASSERT_LT(stats.percentile(0.5), 5'000'000);
+}
+
+TEST(PlaybackTests, TopicFilterAndUnpaced) {
+    writeBag("playback_fast.bag");
+    CRLRosReader::PlaybackOptions options;
+    options.rate = 0;
+    options.topics = {"/chatter"};
+    CRLRosReader::Player player(options);
+    ASSERT_TRUE(player.open("playback_fast.bag"));
+
+    uint64_t count = 0;
+    ASSERT_TRUE(player.play([&](const CRLRosReader::DatasetMessage &message) {
+        ASSERT_EQ(message.connection->topic, "/chatter");
+        ++count;
+    }));
+    ASSERT_EQ(count, 100u);
+    ASSERT_EQ(player.getStats().maxLateness, 0);
+}
+
+TEST(PlaybackTests, StopFromCallback) {
+    writeBag("playback_stop.bag");
+    CRLRosReader::PlaybackOptions options;
+    options.rate = 0.1; // would take two seconds
+    CRLRosReader::Player player(options);
+    ASSERT_TRUE(player.open("playback_stop.bag"));
+
+    uint64_t count = 0;
+    auto begin = std::chrono::steady_clock::now();
+    ASSERT_TRUE(player.play([&](const CRLRosReader::DatasetMessage &) {
+        if (++count == 3)
+            player.stop();
+    }));
+    ASSERT_EQ(count, 3u);
+    ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(1));
+}
+
+// One small /imu message per chunk of images; the queued /imu messages must not keep those chunks alive
+TEST(PlaybackTests, FilteredTopicDoesNotPinChunks) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(150 * 1024);
+        writer.open("playback_sparse.bag");
+        auto camera = writer.getConnection("/camera", "sensor_msgs/Image");
+        auto imu = writer.getConnection("/imu", "std_msgs/String");
+        for (int i = 0; i < 600; ++i) {
+            writer.write(camera, T0 + i * 1'000'000LL, std::vector<uint8_t>(20 * 1024, static_cast<uint8_t>(i)));
+            if (i % 10 == 0)
+                writer.write(imu, T0 + i * 1'000'000LL, std::vector<uint8_t>(100, static_cast<uint8_t>(i)));
+        }
+    }
+
+    CRLRosReader::PlaybackOptions options;
+    options.rate = 0;
+    options.topics = {"/imu"};
+    options.prefetchBytes = 64 * 1024;
+    CRLRosReader::Player player(options);
+    ASSERT_TRUE(player.open("playback_sparse.bag"));
+
+    // Buffers handed to the callback so far; the ones still alive are held by the queue or the I/O thread
+    std::vector<std::weak_ptr<const std::vector<uint8_t>>> buffers;
+    std::vector<size_t> sizes;
+    uint64_t maxLive = 0;
+    uint64_t count = 0;
+    ASSERT_TRUE(player.play([&](const CRLRosReader::DatasetMessage &message) {
+        ++count;
+        buffers.push_back(message.chunk);
+        sizes.push_back(message.chunk->size());
+        uint64_t live = 0;
+        for (size_t i = 0; i < buffers.size(); ++i)
+            live += buffers[i].expired() ? 0 : sizes[i];
+        maxLive = std::max(maxLive, live);
+    }));
+    ASSERT_EQ(count, 60u);
+    // All 60 chunks are ~200 KB each; only copies of the /imu messages may stay alive
+    ASSERT_LT(maxLive, 64u * 1024);
+    ASSERT_LT(player.getStats().peakQueued, 2u * 64 * 1024);
+}
+
+// The I/O thread must be joined when the callback throws, or the next play() terminates the process
+TEST(PlaybackTests, CallbackExceptionAndStatsPolling) {
+    writeBag("playback_throw.bag");
+    CRLRosReader::PlaybackOptions options;
+    options.rate = 20.0;
+    options.prefetchBytes = 4096;
+    CRLRosReader::Player player(options);
+    ASSERT_TRUE(player.open("playback_throw.bag"));
+
+    ASSERT_THROW(player.play([](const CRLRosReader::DatasetMessage &message) {
+        if (message.time >= T0 + 10'000'000)
+            throw std::runtime_error("callback failed");
+    }), std::runtime_error);
+    ASSERT_EQ(player.getStats().delivered, 11u);
+
+    // Stats are polled while playing, the counts only grow
+    std::atomic<bool> done{false};
+    uint64_t polls = 0;
+    std::thread poller([&]() {
+        uint64_t last = 0;
+        while (!done) {
+            CRLRosReader::PlaybackStats stats = player.getStats();
+            EXPECT_GE(stats.delivered, last);
+            last = stats.delivered;
+            ++polls;
+        }
+    });
+    uint64_t count = 0;
+    ASSERT_TRUE(player.play([&](const CRLRosReader::DatasetMessage &) { ++count; }));
+    done = true;
+    poller.join();
+    ASSERT_EQ(count, 200u);
+    ASSERT_EQ(player.getStats().delivered, 200u);
+    ASSERT_GT(polls, 0u);
+}
+
+TEST(PlaybackTests, Percentiles) {
+    CRLRosReader::PlaybackStats stats;
+    ASSERT_EQ(stats.percentile(0.99), 0);
+    stats.histogram.assign(CRLRosReader::PlaybackStats::BUCKETS, 0);
+    stats.histogram[10] = 98;
+    stats.histogram[500] = 1;
+    stats.histogram[CRLRosReader::PlaybackStats::BUCKETS - 1] = 1;
+    stats.delivered = 100;
+    stats.maxLateness = 250'000'000;
+    ASSERT_EQ(stats.percentile(0.5), 11'000);
+    ASSERT_EQ(stats.percentile(0.99), 501'000);
+    ASSERT_EQ(stats.percentile(1.0), 100'000'000);
+}
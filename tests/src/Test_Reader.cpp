@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagReader/RosbagReader.h"
+
+TEST(ReaderTests, SummaryFromIndex) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.open("summary.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        std::vector<uint8_t> data(256, 0x42);
+        for (int i = 0; i < 100; ++i) {
+            writer.write(i % 4 ? conn : conn2, 1'700'000'000'000'000'000 + i * 1'000'000, data);
+        }
+    }
+
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open("summary.bag"));
+    ASSERT_TRUE(reader.readHeader());
+    ASSERT_EQ(reader.getConnections().size(), 2u);
+    ASSERT_GT(reader.getChunks().size(), 1u);
+
+    CRLRosReader::BagSummary summary = reader.summary();
+    ASSERT_EQ(summary.messageCount, 100u);
+    ASSERT_EQ(summary.chunkCount, reader.getChunks().size());
+    ASSERT_EQ(summary.start, 1'700'000'000'000'000'000);
+    ASSERT_EQ(summary.end, 1'700'000'000'000'000'000 + 99 * 1'000'000);
+    ASSERT_EQ(summary.topics.size(), 2u);
+    ASSERT_EQ(summary.topics[0].topic, "/chatter");
+    ASSERT_EQ(summary.topics[0].msgType, "std_msgs/String");
+    ASSERT_EQ(summary.topics[0].messageCount, 75u);
+    ASSERT_EQ(summary.topics[1].messageCount, 25u);
+}
+
+TEST(ReaderTests, EmptyBag) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.open("reader_empty.bag");
+    }
+    CRLRosReader::BagSummary summary;
+    ASSERT_TRUE(CRLRosReader::readSummary("reader_empty.bag", summary));
+    ASSERT_EQ(summary.messageCount, 0u);
+    ASSERT_EQ(summary.chunkCount, 0u);
+    ASSERT_TRUE(summary.topics.empty());
+}
+
+TEST(ReaderTests, RejectsMissingFile) {
+    CRLRosReader::BagSummary summary;
+    ASSERT_FALSE(CRLRosReader::readSummary("does_not_exist.bag", summary));
+}
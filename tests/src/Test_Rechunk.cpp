@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <tuple>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagWriter/BagRechunk.h"
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/BagVerify.h"
+
+using Message = std::tuple<uint32_t, int64_t, std::vector<uint8_t>>;
+
+static std::vector<Message> readAll(const std::string &path) {
+    std::vector<Message> result;
+    CRLRosReader::RosbagReader reader;
+    if (!reader.open(path) || !reader.readHeader())
+        return result;
+    std::vector<CRLRosReader::ChunkInfo> chunks = reader.getChunks();
+    std::sort(chunks.begin(), chunks.end(), [](const auto &a, const auto &b) { return a.pos < b.pos; });
+    CRLRosReader::ChunkRecord chunk;
+    std::vector<CRLRosReader::MessageRecord> messages;
+    for (const auto &info: chunks) {
+        if (!reader.readChunk(info.pos, chunk) || !CRLRosReader::decompressChunk(chunk) ||
+            !CRLRosReader::parseMessages(chunk.data, messages))
+            return {};
+        for (const auto &message: messages)
+            result.emplace_back(message.conn, message.time,
+                                std::vector<uint8_t>(chunk.data.begin() + static_cast<std::ptrdiff_t>(message.begin),
+                                                     chunk.data.begin() + static_cast<std::ptrdiff_t>(message.end)));
+    }
+    return result;
+}
+
+TEST(CompressionTests, Bz2RoundTrip) {
+    if (!CRLRosWriter::isCompressionAvailable(CRLRosWriter::CompressionType::BZ2))
+        GTEST_SKIP() << "bz2 not available";
+    std::string src(100000, 'a');
+    for (size_t i = 0; i < src.size(); i += 7)
+        src[i] = static_cast<char>('a' + i % 26);
+    std::string compressed, restored;
+    ASSERT_TRUE(CRLRosWriter::compress(CRLRosWriter::CompressionType::BZ2, src, compressed));
+    ASSERT_LT(compressed.size(), src.size());
+    ASSERT_TRUE(CRLRosWriter::decompress(CRLRosWriter::CompressionType::BZ2, compressed, restored, src.size()));
+    ASSERT_EQ(restored, src);
+}
+
+// A corrupt chunk must fail instead of stalling the decoder once dst is full
+TEST(CompressionTests, Lz4RejectsBadFrames) {
+    if (!CRLRosWriter::isCompressionAvailable(CRLRosWriter::CompressionType::LZ4))
+        GTEST_SKIP() << "lz4 not available";
+    std::string src(100000, 'a');
+    for (size_t i = 0; i < src.size(); i += 7)
+        src[i] = static_cast<char>('a' + i % 26);
+    std::string compressed, restored;
+    ASSERT_TRUE(CRLRosWriter::compress(CRLRosWriter::CompressionType::LZ4, src, compressed));
+    ASSERT_TRUE(CRLRosWriter::decompress(CRLRosWriter::CompressionType::LZ4, compressed, restored, src.size()));
+    ASSERT_EQ(restored, src);
+
+    ASSERT_FALSE(CRLRosWriter::decompress(CRLRosWriter::CompressionType::LZ4, compressed, restored, src.size() / 2));
+    ASSERT_FALSE(CRLRosWriter::decompress(CRLRosWriter::CompressionType::LZ4,
+                                          compressed.substr(0, compressed.size() / 2), restored, src.size()));
+    ASSERT_FALSE(CRLRosWriter::decompress(CRLRosWriter::CompressionType::LZ4,
+                                          compressed.substr(0, compressed.size() - 4), restored, src.size()));
+}
+
+TEST(RechunkTests, KeepsMessagesAndOrder) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.open("rechunk_in.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        for (int i = 0; i < 2000; ++i) {
+            std::vector<uint8_t> data(64 + i % 50, static_cast<uint8_t>(i));
+            writer.write(i % 3 ? conn : conn2, t0 + i * 1000, data);
+        }
+    }
+
+    CRLRosWriter::RechunkOptions options;
+    options.chunkThreshold = 64 * 1024;
+    options.threads = 4;
+    if (CRLRosWriter::isCompressionAvailable(CRLRosWriter::CompressionType::BZ2))
+        options.compression = CRLRosWriter::CompressionType::BZ2;
+    CRLRosWriter::RechunkResult result;
+    ASSERT_TRUE(CRLRosWriter::rechunkBag("rechunk_in.bag", "rechunk_out.bag", options, result));
+    ASSERT_EQ(result.messages, 2000u);
+    ASSERT_LT(result.outputChunks, result.inputChunks);
+
+    CRLRosReader::BagSummary before, after;
+    ASSERT_TRUE(CRLRosReader::readSummary("rechunk_in.bag", before));
+    ASSERT_TRUE(CRLRosReader::readSummary("rechunk_out.bag", after));
+    ASSERT_EQ(after.messageCount, before.messageCount);
+    ASSERT_EQ(after.start, before.start);
+    ASSERT_EQ(after.end, before.end);
+    ASSERT_EQ(after.chunkCount, result.outputChunks);
+    ASSERT_EQ(after.topics.size(), before.topics.size());
+    if (options.compression == CRLRosWriter::CompressionType::BZ2) {
+        ASSERT_LT(after.fileSize, before.fileSize);
+    }
+
+    CRLRosReader::VerifyResult verify;
+    ASSERT_TRUE(CRLRosReader::verifyBag("rechunk_out.bag", 2, verify));
+    ASSERT_TRUE(verify.ok());
+
+    std::vector<Message> original = readAll("rechunk_in.bag");
+    ASSERT_EQ(original.size(), 2000u);
+    ASSERT_EQ(readAll("rechunk_out.bag"), original);
+}
+
+TEST(RechunkTests, RefusesToOverwriteInput) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.open("rechunk_self.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        for (int i = 0; i < 100; ++i)
+            writer.write(conn, 1'700'000'000'000'000'000 + i, std::vector<uint8_t>(64, static_cast<uint8_t>(i)));
+    }
+    uint64_t size = std::filesystem::file_size("rechunk_self.bag");
+
+    CRLRosWriter::RechunkResult result;
+    ASSERT_FALSE(CRLRosWriter::rechunkBag("rechunk_self.bag", "./rechunk_self.bag", {}, result));
+    ASSERT_EQ(std::filesystem::file_size("rechunk_self.bag"), size);
+    ASSERT_EQ(readAll("rechunk_self.bag").size(), 100u);
+}
+
+TEST(RechunkTests, FailureKeepsExistingOutput) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.open("rechunk_corrupt.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        for (int i = 0; i < 200; ++i)
+            writer.write(conn, 1'700'000'000'000'000'000 + i, std::vector<uint8_t>(512, static_cast<uint8_t>(i)));
+    }
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open("rechunk_corrupt.bag"));
+    ASSERT_TRUE(reader.readHeader());
+    uint64_t pos = reader.getChunks()[5].pos;
+    {
+        // Corrupt the data length of a chunk in the middle so the run fails after output was started
+        std::fstream file("rechunk_corrupt.bag", std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t headerLen = 0;
+        file.seekg(static_cast<std::streamoff>(pos));
+        file.read(reinterpret_cast<char *>(&headerLen), 4);
+        file.seekp(static_cast<std::streamoff>(pos + 4 + headerLen));
+        file.write("\xF0\xFF\xFF\xFF", 4);
+    }
+    {
+        std::ofstream previous("rechunk_kept.bag");
+        previous << "previous";
+    }
+
+    CRLRosWriter::RechunkOptions options;
+    options.threads = 2;
+    CRLRosWriter::RechunkResult result;
+    ASSERT_FALSE(CRLRosWriter::rechunkBag("rechunk_corrupt.bag", "rechunk_kept.bag", options, result));
+    ASSERT_FALSE(std::filesystem::exists("rechunk_kept.bag.tmp"));
+    ASSERT_EQ(std::filesystem::file_size("rechunk_kept.bag"), 8u);
+
+    ASSERT_FALSE(CRLRosWriter::rechunkBag("rechunk_corrupt.bag", "rechunk_none.bag", options, result));
+    ASSERT_FALSE(std::filesystem::exists("rechunk_none.bag"));
+    ASSERT_FALSE(std::filesystem::exists("rechunk_none.bag.tmp"));
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <thread>
+
+#include "RosbagWriter/StripedWriter.h"
+#include "RosbagReader/StripeManifest.h"
+
+TEST(StripedWriterTests, StripesAndManifest) {
+    std::vector<std::filesystem::path> dirs = {"stripe_a", "stripe_b"};
+    for (const auto &dir: dirs)
+        std::filesystem::create_directories(dir);
+
+    {
+        CRLRosWriter::StripedWriter writer;
+        writer.setChunkThreshold(8192);
+        writer.setQueueLimit(16384);
+        writer.open(dirs, "run");
+        std::vector<CRLRosWriter::Connection> conns = {
+                writer.getConnection("/camera/left", "sensor_msgs/Image"),
+                writer.getConnection("/camera/right", "sensor_msgs/Image"),
+                writer.getConnection("/status", "std_msgs/String"),
+        };
+        std::vector<uint8_t> data(512, 0x33);
+        for (int i = 0; i < 300; ++i)
+            writer.write(conns[i % 3], 1'700'000'000'000'000'000 + i * 1'000'000, data);
+    }
+
+    CRLRosReader::StripeManifest manifest;
+    ASSERT_TRUE(CRLRosReader::readStripeManifest("stripe_a/run.stripes", manifest));
+    ASSERT_EQ(manifest.stripes.size(), 2u);
+    ASSERT_EQ(manifest.topics.size(), 3u);
+    ASSERT_GT(manifest.chunks.size(), 2u);
+    ASSERT_TRUE(std::is_sorted(manifest.chunks.begin(), manifest.chunks.end(), [](const auto &a, const auto &b) {
+        return a.start < b.start;
+    }));
+
+    // Each stripe is a standalone bag, together they hold every message
+    uint64_t messages = 0;
+    for (const auto &stripe: manifest.stripes) {
+        CRLRosReader::BagSummary summary;
+        ASSERT_TRUE(CRLRosReader::readSummary(stripe, summary));
+        messages += summary.messageCount;
+    }
+    ASSERT_EQ(messages, 300u);
+
+    auto chunks = manifest.query(1'700'000'000'000'000'000 + 100'000'000, 1'700'000'000'000'000'000 + 110'000'000);
+    ASSERT_FALSE(chunks.empty());
+    ASSERT_LT(chunks.size(), manifest.chunks.size());
+}
+
+TEST(StripedWriterTests, ReopenAfterClose) {
+    std::vector<std::filesystem::path> dirs = {"stripe_reopen_a", "stripe_reopen_b"};
+    for (const auto &dir: dirs)
+        std::filesystem::create_directories(dir);
+
+    CRLRosWriter::StripedWriter writer;
+    writer.open(dirs, "first");
+    auto first = writer.getConnection("/status", "std_msgs/String");
+    auto imu = writer.getConnection("/imu", "sensor_msgs/Imu");
+    std::vector<uint8_t> data(64, 0x11);
+    for (int i = 0; i < 10; ++i)
+        writer.write(i % 2 ? imu : first, 1'700'000'000'000'000'000 + i, data);
+    writer.close();
+
+    // Dropped, the stripes of the first recording are closed
+    writer.write(first, 1'700'000'000'000'000'100, data);
+
+    writer.open(dirs, "second");
+    auto camera = writer.getConnection("/camera", "sensor_msgs/Image");
+    auto status = writer.getConnection("/status", "std_msgs/String");
+    for (int i = 0; i < 20; ++i)
+        writer.write(i % 2 ? camera : status, 1'700'000'000'000'000'000 + i, data);
+    writer.close();
+
+    CRLRosReader::StripeManifest manifest;
+    ASSERT_TRUE(CRLRosReader::readStripeManifest("stripe_reopen_a/first.stripes", manifest));
+    ASSERT_EQ(manifest.topics.size(), 2u);
+    ASSERT_TRUE(CRLRosReader::readStripeManifest("stripe_reopen_a/second.stripes", manifest));
+    ASSERT_EQ(manifest.stripes.size(), 2u);
+    ASSERT_EQ(manifest.topics.size(), 2u);
+    uint64_t messages = 0;
+    for (const auto &stripe: manifest.stripes) {
+        CRLRosReader::BagSummary summary;
+        ASSERT_TRUE(CRLRosReader::readSummary(stripe, summary));
+        ASSERT_EQ(summary.topics.size(), 1u);
+        messages += summary.messageCount;
+    }
+    ASSERT_EQ(messages, 20u);
+}
+
+TEST(StripedWriterTests, ConcurrentProducers) {
+    std::vector<std::filesystem::path> dirs = {"stripe_mt_a", "stripe_mt_b", "stripe_mt_c"};
+    for (const auto &dir: dirs)
+        std::filesystem::create_directories(dir);
+
+    {
+        CRLRosWriter::StripedWriter writer;
+        writer.setChunkThreshold(8192);
+        writer.setQueueLimit(16384);
+        writer.open(dirs, "run");
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 4; ++t) {
+            producers.emplace_back([&writer, t]() {
+                std::vector<uint8_t> data(256, static_cast<uint8_t>(t));
+                for (int i = 0; i < 200; ++i) {
+                    auto own = writer.getConnection("/sensor_" + std::to_string(t), "std_msgs/String");
+                    auto shared = writer.getConnection("/shared", "std_msgs/String");
+                    writer.write(i % 2 ? own : shared, 1'700'000'000'000'000'000 + i * 1000 + t, data);
+                }
+            });
+        }
+        for (auto &producer: producers)
+            producer.join();
+    }
+
+    CRLRosReader::StripeManifest manifest;
+    ASSERT_TRUE(CRLRosReader::readStripeManifest("stripe_mt_a/run.stripes", manifest));
+    ASSERT_EQ(manifest.topics.size(), 5u);
+    uint64_t messages = 0;
+    for (const auto &stripe: manifest.stripes) {
+        CRLRosReader::BagSummary summary;
+        ASSERT_TRUE(CRLRosReader::readSummary(stripe, summary));
+        messages += summary.messageCount;
+    }
+    ASSERT_EQ(messages, 800u);
+}
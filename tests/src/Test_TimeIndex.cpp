@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/TimeIndex.h"
+
+TEST(TimeIndexTests, SeekWithoutScanning) {
+    const int64_t t0 = 1'700'000'000'000'000'000;
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.setTimeIndex(true);
+        writer.open("time_index.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        std::vector<uint8_t> data(128, 0x77);
+        for (int i = 0; i < 500; ++i)
+            writer.write(i % 5 ? conn : conn2, t0 + i * 1'000'000, data);
+    }
+
+    CRLRosReader::TimeIndex index;
+    ASSERT_TRUE(index.open("time_index.bag"));
+    ASSERT_EQ(index.getConnections(), (std::vector<uint32_t>{0, 1}));
+    ASSERT_EQ(index.count(0), 400u);
+    ASSERT_EQ(index.count(1), 100u);
+    ASSERT_TRUE(std::is_sorted(index.begin(0), index.end(0), [](const auto &a, const auto &b) {
+        return a.time < b.time;
+    }));
+
+    // conn2 has messages at i = 0, 5, 10, ... so t0 + 251 ms lands on i = 255
+    const CRLRosReader::TimeIndexEntry *entry = index.seek(1, t0 + 251'000'000);
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->time, t0 + 255'000'000);
+    ASSERT_EQ(index.seek(1, t0 + 1'000'000'000), nullptr);
+
+    // The entry points at the MSGDATA record of that message
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open("time_index.bag"));
+    CRLRosReader::ChunkRecord chunk;
+    ASSERT_TRUE(reader.readChunk(entry->chunkPos, chunk));
+    size_t pos = entry->offset;
+    uint32_t headerLen = CRLRosReader::deserialize_uint32(chunk.data, pos);
+    CRLRosReader::Header header;
+    ASSERT_TRUE(header.parse(chunk.data, pos, pos + headerLen));
+    ASSERT_EQ(header.get_uint32("conn"), 1u);
+    ASSERT_EQ(header.get_time("time"), t0 + 255'000'000);
+}
+
+TEST(TimeIndexTests, RejectsCorruptSidecar) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.setTimeIndex(true);
+        writer.open("time_index_corrupt.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        auto conn2 = writer.getConnection("/temperature", "sensor_msgs/Temperature");
+        for (int i = 0; i < 100; ++i)
+            writer.write(i % 2 ? conn : conn2, 1'700'000'000'000'000'000 + i, std::vector<uint8_t>(32, 0x11));
+    }
+    const std::filesystem::path sidecar = CRLRosReader::TimeIndex::sidecarPath("time_index_corrupt.bag");
+    std::string original;
+    {
+        std::ifstream file(sidecar, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    auto opens = [&](const std::string &bytes) {
+        {
+            std::ofstream file(sidecar, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        CRLRosReader::TimeIndex index;
+        return index.open("time_index_corrupt.bag");
+    };
+    // Header, then directory entries of {conn, reserved, offset, count}
+    auto patch = [&](size_t pos, uint64_t value, size_t bytes) {
+        std::string copy = original;
+        std::memcpy(copy.data() + pos, &value, bytes);
+        return copy;
+    };
+    const size_t offsetPos = sizeof(CRLRosWriter::TimeIndexFileHeader) + 8;
+    const size_t countPos = offsetPos + 8;
+
+    ASSERT_TRUE(opens(original));
+    ASSERT_FALSE(opens(original.substr(0, original.size() - sizeof(CRLRosReader::TimeIndexEntry))));
+    ASSERT_FALSE(opens(patch(8, 0xFFFFFFFF, 4)));                               // connCount
+    ASSERT_FALSE(opens(patch(offsetPos, original.size() + 24, 8)));             // run past the end
+    ASSERT_FALSE(opens(patch(offsetPos, 4, 8)));                                // inside the header, misaligned
+    ASSERT_FALSE(opens(patch(countPos, 0x0AAAAAAAAAAAAAABULL, 8)));             // count * 24 wraps around
+    ASSERT_FALSE(opens(patch(sizeof(CRLRosWriter::TimeIndexFileHeader), 7, 4))); // directory out of order
+    ASSERT_TRUE(opens(original));
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <fstream>
+
+#include "RosbagWriter/RosbagWriter.h"
+#include "RosbagWriter/Crc32c.h"
+#include "RosbagReader/RosbagReader.h"
+#include "RosbagReader/BagVerify.h"
+
+TEST(Crc32cTests, KnownValue) {
+    const char *check = "123456789";
+    ASSERT_EQ(CRLRosWriter::crc32c(check, 9), 0xE3069283u);
+    ASSERT_EQ(CRLRosWriter::crc32c_sw(check, 9), 0xE3069283u);
+}
+
+TEST(Crc32cTests, HardwareMatchesSoftware) {
+    std::vector<uint8_t> data(4099);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    for (size_t size: {0u, 1u, 7u, 8u, 9u, 1000u, 4099u}) {
+        ASSERT_EQ(CRLRosWriter::crc32c(data.data(), size), CRLRosWriter::crc32c_sw(data.data(), size));
+    }
+    // Chained computation equals the one shot result
+    uint32_t crc = CRLRosWriter::crc32c(data.data(), 1000);
+    ASSERT_EQ(CRLRosWriter::crc32c(data.data() + 1000, 3099, crc), CRLRosWriter::crc32c(data.data(), 4099));
+}
+
+TEST(VerifyTests, DetectsCorruptChunk) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.open("verify.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        std::vector<uint8_t> data(512, 0x5A);
+        for (int i = 0; i < 64; ++i)
+            writer.write(conn, 1'700'000'000'000'000'000 + i, data);
+    }
+
+    CRLRosReader::VerifyResult result;
+    ASSERT_TRUE(CRLRosReader::verifyBag("verify.bag", 4, result));
+    ASSERT_TRUE(result.ok());
+    ASSERT_GT(result.chunks, 1u);
+    ASSERT_EQ(result.verified, result.chunks);
+
+    // Flip one payload byte in the second chunk
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open("verify.bag"));
+    ASSERT_TRUE(reader.readHeader());
+    uint64_t pos = reader.getChunks()[1].pos;
+    {
+        std::fstream file("verify.bag", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(pos + 200));
+        file.put('\x00');
+    }
+
+    ASSERT_TRUE(CRLRosReader::verifyBag("verify.bag", 4, result));
+    ASSERT_FALSE(result.ok());
+    ASSERT_EQ(result.corrupt.size(), 1u);
+    ASSERT_EQ(result.corrupt[0], pos);
+}
+
+TEST(VerifyTests, CorruptChunkLength) {
+    {
+        CRLRosWriter::RosbagWriter writer;
+        writer.setChunkThreshold(4096);
+        writer.open("verify_length.bag");
+        auto conn = writer.getConnection("/chatter", "std_msgs/String");
+        std::vector<uint8_t> data(512, 0x5A);
+        for (int i = 0; i < 64; ++i)
+            writer.write(conn, 1'700'000'000'000'000'000 + i, data);
+    }
+
+    CRLRosReader::RosbagReader reader;
+    ASSERT_TRUE(reader.open("verify_length.bag"));
+    ASSERT_TRUE(reader.readHeader());
+    uint64_t pos = reader.getChunks()[1].pos;
+    {
+        // Set the data length of the second chunk to almost 4 GiB, the record is <header_len><header><data_len>
+        std::fstream file("verify_length.bag", std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t headerLen = 0;
+        file.seekg(static_cast<std::streamoff>(pos));
+        file.read(reinterpret_cast<char *>(&headerLen), 4);
+        file.seekp(static_cast<std::streamoff>(pos + 4 + headerLen));
+        file.write("\xF0\xFF\xFF\xFF", 4);
+    }
+
+    CRLRosReader::ChunkRecord chunk;
+    CRLRosReader::RosbagReader corrupted;
+    ASSERT_TRUE(corrupted.open("verify_length.bag"));
+    ASSERT_FALSE(corrupted.readChunk(pos, chunk));
+    ASSERT_FALSE(corrupted.readChunk(std::numeric_limits<uint64_t>::max() - 4, chunk));
+
+    CRLRosReader::VerifyResult result;
+    ASSERT_TRUE(CRLRosReader::verifyBag("verify_length.bag", 2, result));
+    ASSERT_EQ(result.corrupt.size(), 1u);
+    ASSERT_EQ(result.corrupt[0], pos);
+}
@@ -0,0 +1,58 @@
+//
+// Dumps image topics to PNG files and scalar topics to CSV or binary arrays.
+// Usage: rosbag_export [-j threads] [-o dir] [-t topic]... [--binary] [--png-level 0-9] <bag>
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <RosbagReader/BagExport.h>
+
+int main(int argc, char **argv) {
+    CRLRosReader::ExportOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    options.outputDir = "export";
+    std::filesystem::path bag;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc)
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        else if (arg == "-o" && i + 1 < argc)
+            options.outputDir = argv[++i];
+        else if (arg == "-t" && i + 1 < argc)
+            options.topics.emplace_back(argv[++i]);
+        else if (arg == "--binary")
+            options.binary = true;
+        else if (arg == "--png-level" && i + 1 < argc)
+            options.pngCompression = std::clamp(std::atoi(argv[++i]), 0, 9);
+        else
+            bag = arg;
+    }
+    if (bag.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-o dir] [-t topic]... [--binary] [--png-level 0-9] <bag>"
+                  << std::endl;
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    CRLRosReader::ExportResult result;
+    if (!CRLRosReader::exportBag(bag, options, result)) {
+        std::cerr << bag.string() << ": export failed" << std::endl;
+        return 1;
+    }
+    double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(), 1e-9);
+
+    std::cout << bag.string() << ": " << result.images << " images, " << result.rows << " rows";
+    if (result.skipped > 0)
+        std::cout << ", " << result.skipped << " skipped";
+    std::cout << " -> " << options.outputDir.string() << std::fixed << std::setprecision(1) << " (read "
+              << static_cast<double>(result.bytesRead) / (1 << 20) / seconds << " MB/s, wrote "
+              << static_cast<double>(result.bytesWritten) / (1 << 20) / seconds << " MB/s)" << std::endl;
+    for (uint64_t pos: result.failedChunks)
+        std::cout << "  unreadable chunk at offset " << pos << std::endl;
+    return result.failedChunks.empty() ? 0 : 2;
+}
@@ -0,0 +1,55 @@
+//
+// Replays bags at the recorded pace and reports the delivery jitter.
+// Usage: rosbag_play [-r rate] [-t topic]... [-p prefetch_mb] <bag or directory>...
+// A directory plays all of its bags as one recording.
+//
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <RosbagReader/Player.h>
+
+int main(int argc, char **argv) {
+    CRLRosReader::PlaybackOptions options;
+    std::vector<std::filesystem::path> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            options.rate = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "-t" && i + 1 < argc) {
+            options.topics.emplace_back(argv[++i]);
+        } else if (arg == "-p" && i + 1 < argc) {
+            options.prefetchBytes = static_cast<uint64_t>(std::max(1L, std::atol(argv[++i]))) << 20;
+        } else {
+            paths.emplace_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-r rate] [-t topic]... [-p prefetch_mb] <bag or directory>..."
+                  << std::endl;
+        return 1;
+    }
+
+    CRLRosReader::Player player(options);
+    bool opened = paths.size() == 1 && std::filesystem::is_directory(paths[0]) ? player.openDirectory(paths[0])
+                                                                               : player.open(paths);
+    if (!opened)
+        return 1;
+
+    uint64_t bytes = 0;
+    bool ok = player.play([&](const CRLRosReader::DatasetMessage &message) { bytes += message.size(); });
+
+    CRLRosReader::PlaybackStats stats = player.getStats();
+    std::cout << std::left << std::fixed << std::setprecision(1)
+              << std::setw(12) << "delivered:" << stats.delivered << " msgs, " << bytes << " bytes\n"
+              << std::setw(12) << "underruns:" << stats.underruns << "\n"
+              << std::setw(12) << "lateness:" << "mean " << stats.meanLateness / 1e3 << " us"
+              << ", p50 " << static_cast<double>(stats.percentile(0.5)) / 1e3 << " us"
+              << ", p99 " << static_cast<double>(stats.percentile(0.99)) / 1e3 << " us"
+              << ", max " << static_cast<double>(stats.maxLateness) / 1e3 << " us" << std::endl;
+    return ok ? 0 : 1;
+}
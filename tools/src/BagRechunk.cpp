@@ -0,0 +1,60 @@
+//
+// Rewrites a bag with a different chunk compression and chunk size.
+// Usage: rosbag_rechunk [-j threads] [-c none|lz4|bz2] [-s chunk_kb] <input> <output>
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <RosbagWriter/BagRechunk.h>
+
+int main(int argc, char **argv) {
+    CRLRosWriter::RechunkOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::filesystem::path> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            options.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        } else if (arg == "-s" && i + 1 < argc) {
+            options.chunkThreshold = static_cast<uint64_t>(std::max(1L, std::atol(argv[++i]))) * 1024;
+        } else if (arg == "-c" && i + 1 < argc) {
+            std::string codec = argv[++i];
+            if (codec == "none")
+                options.compression = CRLRosWriter::CompressionType::NONE;
+            else if (codec == "lz4")
+                options.compression = CRLRosWriter::CompressionType::LZ4;
+            else if (codec == "bz2")
+                options.compression = CRLRosWriter::CompressionType::BZ2;
+            else {
+                std::cerr << "Unknown compression " << codec << std::endl;
+                return 1;
+            }
+        } else {
+            paths.emplace_back(arg);
+        }
+    }
+    if (paths.size() != 2) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [-c none|lz4|bz2] [-s chunk_kb] <input> <output>"
+                  << std::endl;
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    CRLRosWriter::RechunkResult result;
+    if (!CRLRosWriter::rechunkBag(paths[0], paths[1], options, result)) {
+        std::cerr << paths[0].string() << ": rechunk failed" << std::endl;
+        return 2;
+    }
+    double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(), 1e-9);
+    std::cout << paths[0].string() << " -> " << paths[1].string() << ": " << result.messages << " messages, "
+              << result.inputChunks << " -> " << result.outputChunks << " chunks, " << std::fixed
+              << std::setprecision(1) << static_cast<double>(result.bytesRead) / (1 << 20) << " MB -> "
+              << static_cast<double>(result.bytesWritten) / (1 << 20) << " MB in " << seconds << " s" << std::endl;
+    return 0;
+}
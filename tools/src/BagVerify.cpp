@@ -0,0 +1,54 @@
+//
+// Verifies the crc32c of every chunk before the on-robot copy of a bag is deleted.
+// Usage: rosbag_verify [-j threads] <bag>...
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <RosbagReader/BagVerify.h>
+
+int main(int argc, char **argv) {
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::filesystem::path> bags;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc)
+            threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        else
+            bags.emplace_back(arg);
+    }
+    if (bags.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] <bag>..." << std::endl;
+        return 1;
+    }
+
+    int failed = 0;
+    for (const auto &bag: bags) {
+        auto begin = std::chrono::steady_clock::now();
+        CRLRosReader::VerifyResult result;
+        if (!CRLRosReader::verifyBag(bag, threads, result)) {
+            std::cout << bag.string() << ": FAILED (could not read index)" << std::endl;
+            ++failed;
+            continue;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        std::cout << bag.string() << ": " << (result.ok() ? "OK" : "CORRUPT") << " " << result.verified << "/"
+                  << result.chunks << " chunks verified";
+        if (result.unchecked > 0)
+            std::cout << ", " << result.unchecked << " without checksum";
+        std::cout << " (" << std::fixed << std::setprecision(1)
+                  << static_cast<double>(result.bytes) / (1 << 20) / std::max(seconds, 1e-9) << " MB/s)" << std::endl;
+        for (uint64_t pos: result.corrupt)
+            std::cout << "  bad chunk at offset " << pos << std::endl;
+        if (!result.ok())
+            ++failed;
+    }
+    return failed == 0 ? 0 : 2;
+}